@@ -0,0 +1,320 @@
+#pragma once
+// Precompiled grammar artifacts. Normalizing a large grammar (convertToCNF,
+// the GNF pipeline) and building its parse tables dominates startup, so the
+// result is written once (cfgc.cpp) into a file that a process maps read-only
+// and uses in place: no parsing, no allocation, and every process mapping the
+// same file shares one page-cached copy.
+//
+// Layout (host byte order): a 64-byte header, a table of section entries,
+// then the sections, each aligned to 64 bytes. A section is a flat array of
+// fixed-size elements identified by an ArtifactSectionId. The checksum covers
+// everything after the header and is checked when the file is opened.
+// Files are replaced by rename, so a process that has one mapped keeps a
+// consistent view while a new version is written.
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "grammar.h"
+
+// Normal form the stored grammar is in
+enum ArtifactKind : uint32_t { PlainGrammar = 0, CNFGrammar = 1, GNFGrammar = 2 };
+
+enum ArtifactSectionId : uint32_t
+{
+    // Grammar (see Grammar in grammar.h)
+    GrammarStart = 1,  // uint32_t: the start symbol
+    SymbolChars,       // char: every symbol name, back to back
+    SymbolNameBegin,   // uint32_t per symbol, plus one: name s is chars [begin[s], begin[s + 1])
+    SymbolTerminal,    // uint8_t per symbol
+    RuleBegin,         // uint32_t per symbol, plus one
+    RhsBegin,          // uint32_t per production, plus one
+    RhsSymbols,        // Symbol: every right-hand side
+    // CYK tables (see CNFTables in cnf.h)
+    CYKHeader = 32,    // uint64_t: start (or ~0), acceptsEmpty, symbols, ntWords, ruleWords
+    CYKRuleLhs,        // Symbol per binary rule
+    CYKAsLeft,         // uint64_t: [symbol][ruleWords]
+    CYKAsRight,        // uint64_t: [symbol][ruleWords]
+    CYKByTerminal,     // uint64_t: [byte][ntWords]
+    // LALR(1) tables (see LALRTables in lalr.h)
+    LALRHeader = 64,   // uint64_t: states, columns, nonterminals, productions, endColumn, actionSize, gotoSize
+    LALRInts,          // int32_t: termColumn, then the ACTION and GOTO arrays
+    LALRRules,         // uint32_t: lhs per production, then length per production
+};
+
+struct ArtifactHeader
+{
+    char magic[8];       // "CFGARTIF"
+    uint32_t version;
+    uint32_t byteOrder;  // 0x01020304 as written by the producing host
+    uint64_t fileSize;
+    uint64_t checksum;   // artifactChecksum of bytes [64, fileSize)
+    uint32_t kind;       // ArtifactKind
+    uint32_t sections;   // Entries in the section table that follows
+    uint64_t reserved[3];
+};
+static_assert(sizeof(ArtifactHeader) == 64, "the header is mapped as is");
+
+struct ArtifactSection
+{
+    uint32_t id;       // ArtifactSectionId
+    uint32_t elemSize; // Bytes per element, checked against the reader's type
+    uint64_t offset;   // From the start of the file, a multiple of 64
+    uint64_t count;    // Elements
+};
+static_assert(sizeof(ArtifactSection) == 24, "section entries are mapped as is");
+
+constexpr uint32_t artifactVersion = 1;
+
+// Word-at-a-time hash of a 64-bit aligned buffer whose size is a multiple
+// of 8 (sections are padded); four independent lanes keep the multiplier
+// busy, so checking a mapped file runs at memory speed
+inline uint64_t artifactChecksum(const void *data, size_t bytes)
+{
+    auto mix = [](uint64_t h, uint64_t w) {
+        h = (h ^ w) * 0x9E3779B97F4A7C15ULL;
+        return h ^ (h >> 29);
+    };
+    const unsigned char *p = (const unsigned char *)data;
+    uint64_t lane[4] = {1, 2, 3, 4}, w;
+    size_t i = 0;
+    for (; i + 32 <= bytes; i += 32)
+        for (int k = 0; k < 4; k++)
+        {
+            std::memcpy(&w, p + i + 8 * k, 8);
+            lane[k] = mix(lane[k], w);
+        }
+    for (int k = 0; i + 8 <= bytes; i += 8, k++)
+    {
+        std::memcpy(&w, p + i, 8);
+        lane[k] = mix(lane[k], w);
+    }
+    return mix(mix(mix(mix(mix(bytes, lane[0]), lane[1]), lane[2]), lane[3]), 0);
+}
+
+// Collects sections in memory and writes the artifact in one go
+class ArtifactWriter
+{
+  public:
+    explicit ArtifactWriter(ArtifactKind kind) : kind(kind) {}
+
+    template <class T>
+    void add(ArtifactSectionId id, const T *data, size_t count)
+    {
+        const char *bytes = (const char *)data;
+        pending.push_back({{id, (uint32_t)sizeof(T), 0, count}, std::string(bytes, bytes + count * sizeof(T))});
+    }
+    template <class T>
+    void add(ArtifactSectionId id, const std::vector<T> &v) { add(id, v.data(), v.size()); }
+
+    // Write to `path` via a temporary file and rename; false on I/O errors
+    bool save(const std::string &path) const
+    {
+        auto align = [](uint64_t x) { return (x + 63) & ~(uint64_t)63; };
+        uint64_t size = align(sizeof(ArtifactHeader) + pending.size() * sizeof(ArtifactSection));
+        std::vector<ArtifactSection> table;
+        for (auto &[entry, bytes] : pending)
+        {
+            table.push_back(entry);
+            table.back().offset = size;
+            size = align(size + bytes.size());
+        }
+
+        std::vector<uint64_t> image(size / 8, 0); // uint64_t keeps the image aligned for the checksum
+        char *base = (char *)image.data();
+        std::memcpy(base + sizeof(ArtifactHeader), table.data(), table.size() * sizeof(ArtifactSection));
+        for (size_t s = 0; s < pending.size(); s++)
+            std::memcpy(base + table[s].offset, pending[s].second.data(), pending[s].second.size());
+
+        ArtifactHeader h = {};
+        std::memcpy(h.magic, "CFGARTIF", 8);
+        h.version = artifactVersion;
+        h.byteOrder = 0x01020304;
+        h.fileSize = size;
+        h.checksum = artifactChecksum(base + sizeof h, size - sizeof h);
+        h.kind = kind;
+        h.sections = pending.size();
+        std::memcpy(base, &h, sizeof h);
+
+        std::string temp = path + ".tmp";
+        FILE *f = std::fopen(temp.c_str(), "wb");
+        if (!f)
+            return false;
+        bool ok = std::fwrite(base, 1, size, f) == size;
+        ok = std::fclose(f) == 0 && ok;
+        ok = ok && std::rename(temp.c_str(), path.c_str()) == 0;
+        if (!ok)
+            std::remove(temp.c_str());
+        return ok;
+    }
+
+  private:
+    ArtifactKind kind;
+    std::vector<std::pair<ArtifactSection, std::string>> pending; // Entry (offset unset), contents
+};
+
+// A mapped artifact. open() validates the header, the section table and the
+// checksum; sections are then read in place for as long as the object lives.
+class Artifact
+{
+  public:
+    std::string error; // Why open() failed
+
+    Artifact() = default;
+    Artifact(const Artifact &) = delete;
+    Artifact &operator=(const Artifact &) = delete;
+    ~Artifact() { close(); }
+
+    bool open(const std::string &path)
+    {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return fail("cannot open " + path);
+        struct stat st;
+        if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ArtifactHeader))
+        {
+            ::close(fd);
+            return fail(path + " is too short to be an artifact");
+        }
+        void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd); // The mapping keeps the file alive
+        if (p == MAP_FAILED)
+            return fail("cannot map " + path);
+        base = (const char *)p, size = st.st_size;
+
+        const ArtifactHeader &h = header();
+        if (std::memcmp(h.magic, "CFGARTIF", 8) != 0)
+            return fail(path + " is not a grammar artifact");
+        if (h.byteOrder != 0x01020304)
+            return fail(path + " was written on a host with another byte order");
+        if (h.version != artifactVersion)
+            return fail(path + " has format version " + std::to_string(h.version) + ", expected " +
+                        std::to_string(artifactVersion));
+        if (h.fileSize != size || size % 8 != 0 ||
+            (size - sizeof h) / sizeof(ArtifactSection) < h.sections)
+            return fail(path + " is truncated");
+        if (artifactChecksum(base + sizeof h, size - sizeof h) != h.checksum)
+            return fail(path + " is corrupt (checksum mismatch)");
+        for (uint32_t s = 0; s < h.sections; s++)
+        {
+            const ArtifactSection &e = table()[s];
+            if (e.offset % 64 != 0 || e.offset > size || e.elemSize == 0 || e.count > (size - e.offset) / e.elemSize)
+                return fail(path + " has a section outside the file");
+        }
+        return true;
+    }
+
+    bool isOpen() const { return base != nullptr; }
+    const ArtifactHeader &header() const { return *(const ArtifactHeader *)base; }
+    const ArtifactSection *table() const { return (const ArtifactSection *)(base + sizeof(ArtifactHeader)); }
+
+    // Section `id` as an array of T, or nullptr if it is missing or holds
+    // elements of another size; `count` receives its length
+    template <class T>
+    const T *section(ArtifactSectionId id, size_t &count) const
+    {
+        count = 0;
+        for (uint32_t s = 0; s < header().sections; s++)
+            if (table()[s].id == id)
+            {
+                if (table()[s].elemSize != sizeof(T))
+                    return nullptr;
+                count = table()[s].count;
+                return (const T *)(base + table()[s].offset);
+            }
+        return nullptr;
+    }
+
+  private:
+    const char *base = nullptr;
+    size_t size = 0;
+
+    bool fail(const std::string &why)
+    {
+        close();
+        error = why;
+        return false;
+    }
+    void close()
+    {
+        if (base)
+            munmap((void *)base, size);
+        base = nullptr, size = 0;
+    }
+};
+
+// Read-only grammar over a mapped artifact, with the accessors of Grammar
+struct GrammarView
+{
+    Symbol start = 0;
+    size_t symbols = 0, productions = 0;
+    const char *chars = nullptr;
+    const uint32_t *nameBegin = nullptr;
+    const uint8_t *terminal = nullptr;
+    const uint32_t *ruleBegin = nullptr; // symbols + 1 entries
+    const uint32_t *rhsBegin = nullptr;  // productions + 1 entries
+    const Symbol *rhs = nullptr;
+
+    size_t symbolCount() const { return symbols; }
+    bool isTerminal(Symbol s) const { return terminal[s]; }
+    bool isNonTerminal(Symbol s) const { return !terminal[s]; }
+    std::string_view name(Symbol s) const { return {chars + nameBegin[s], nameBegin[s + 1] - nameBegin[s]}; }
+
+    uint32_t firstRule(Symbol A) const { return ruleBegin[A]; }
+    uint32_t lastRule(Symbol A) const { return ruleBegin[A + 1]; }
+    size_t ruleCount(Symbol A) const { return lastRule(A) - firstRule(A); }
+    size_t productionCount() const { return productions; }
+    Rhs production(uint32_t p) const { return {rhs + rhsBegin[p], rhs + rhsBegin[p + 1]}; }
+};
+
+inline void addGrammar(ArtifactWriter &out, const Grammar &G)
+{
+    std::string chars;
+    std::vector<uint32_t> nameBegin{0}, ruleBegin;
+    for (auto &name : G.symbols.names)
+    {
+        chars += name;
+        nameBegin.push_back(chars.size());
+    }
+    // Symbols interned after the last pack have no entry yet
+    for (Symbol A = 0; A <= G.symbols.size(); A++)
+        ruleBegin.push_back(A < G.ruleBegin.size() ? G.ruleBegin[A] : G.productionCount());
+    uint32_t start = G.start;
+    out.add(GrammarStart, &start, 1);
+    out.add(SymbolChars, chars.data(), chars.size());
+    out.add(SymbolNameBegin, nameBegin);
+    out.add(SymbolTerminal, G.symbols.terminal);
+    out.add(RuleBegin, ruleBegin);
+    out.add(RhsBegin, G.rhsBegin);
+    out.add(RhsSymbols, G.rhs);
+}
+
+// Point `G` at the grammar stored in `art`; false if sections are missing or
+// their sizes disagree
+inline bool viewGrammar(const Artifact &art, GrammarView &G)
+{
+    size_t starts, chars, names, terminals, rules, rhsBegins, rhsCount;
+    const uint32_t *start = art.section<uint32_t>(GrammarStart, starts);
+    G.chars = art.section<char>(SymbolChars, chars);
+    G.nameBegin = art.section<uint32_t>(SymbolNameBegin, names);
+    G.terminal = art.section<uint8_t>(SymbolTerminal, terminals);
+    G.ruleBegin = art.section<uint32_t>(RuleBegin, rules);
+    G.rhsBegin = art.section<uint32_t>(RhsBegin, rhsBegins);
+    G.rhs = art.section<Symbol>(RhsSymbols, rhsCount);
+    if (!start || starts != 1 || !G.nameBegin || !G.terminal || !G.ruleBegin || !G.rhsBegin || names == 0 ||
+        rhsBegins == 0)
+        return false;
+    G.symbols = terminals;
+    G.productions = rhsBegins - 1;
+    G.start = *start;
+    return names == G.symbols + 1 && rules == G.symbols + 1 && G.start < G.symbols &&
+           G.nameBegin[G.symbols] == chars && G.ruleBegin[G.symbols] == G.productions &&
+           G.rhsBegin[G.productions] == rhsCount;
+}
@@ -0,0 +1,213 @@
+#pragma once
+// Batch mode shared by the simulators' main()s: the caller sets up its grammar
+// or transition table once, then every newline-delimited input read from a
+// file (or stdin) is decided with it. One line is written per input, "accept"
+// or "reject" (LBAs may also answer "loops" or "step-limit"), in input order;
+// aggregate throughput goes to stderr so stdout stays machine-readable.
+//
+//   ./cfg --batch inputs.txt
+//   generate | ./lba2 --batch --threads 8
+//
+// Inputs are decided in parallel by a work-stealing pool (parallelFor below).
+// Input costs are very skewed (one long a^n b^n can outweigh thousands of
+// short strings), so idle workers steal from busy ones instead of relying
+// on a static split.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// True if argv contains "--batch [file]"; `path` is the file, or "-" for stdin
+inline bool batchRequested(int argc, char *argv[], std::string &path)
+{
+    for (int i = 1; i < argc; i++)
+        if (std::strcmp(argv[i], "--batch") == 0)
+        {
+            path = (i + 1 < argc && argv[i + 1][0] != '-') ? argv[i + 1] : "-";
+            return true;
+        }
+    return false;
+}
+
+// True if argv contains `flag` (e.g. "--earley")
+inline bool hasFlag(int argc, char *argv[], const char *flag)
+{
+    for (int i = 1; i < argc; i++)
+        if (std::strcmp(argv[i], flag) == 0)
+            return true;
+    return false;
+}
+
+// Value N of "flag N" in argv, or `fallback` if the flag is absent
+inline size_t flagValue(int argc, char *argv[], const char *flag, size_t fallback)
+{
+    for (int i = 1; i + 1 < argc; i++)
+        if (std::strcmp(argv[i], flag) == 0)
+            return std::strtoull(argv[i + 1], nullptr, 10);
+    return fallback;
+}
+
+// Argument after `flag` in argv, or `fallback` if the flag is absent
+inline std::string flagText(int argc, char *argv[], const char *flag, const std::string &fallback = "")
+{
+    for (int i = 1; i + 1 < argc; i++)
+        if (std::strcmp(argv[i], flag) == 0)
+            return argv[i + 1];
+    return fallback;
+}
+
+// Worker count from "--threads N"; all hardware threads by default
+inline unsigned batchThreads(int argc, char *argv[])
+{
+    size_t threads = flagValue(argc, argv, "--threads", std::thread::hardware_concurrency());
+    return (unsigned)std::max<size_t>(1, threads);
+}
+
+// One worker's deque of pending indices, kept as the range [begin, end): the
+// owner pops single indices from the front, thieves take the back half.
+struct alignas(64) WorkDeque
+{
+    std::mutex lock;
+    size_t begin = 0, end = 0;
+};
+
+// Run task(i) for every i in [0, n) on `threads` workers. Each worker calls
+// its own copy of `task`, so state the task carries (scratch buffers and the
+// like) is never shared between threads. Workers start with equal contiguous
+// shares; one that runs dry steals half of the largest remaining share.
+template <class Task>
+void parallelFor(size_t n, unsigned threads, const Task &task)
+{
+    threads = (unsigned)std::min<size_t>(threads, n);
+    if (threads <= 1)
+    {
+        Task local = task;
+        for (size_t i = 0; i < n; i++)
+            local(i);
+        return;
+    }
+
+    std::vector<WorkDeque> deques(threads);
+    for (unsigned w = 0; w < threads; w++)
+        deques[w].begin = n * w / threads, deques[w].end = n * (w + 1) / threads;
+
+    auto worker = [&](unsigned self) {
+        Task local = task;
+        WorkDeque &mine = deques[self];
+        while (true)
+        {
+            size_t i;
+            {
+                std::lock_guard<std::mutex> guard(mine.lock);
+                i = mine.begin < mine.end ? mine.begin++ : n;
+            }
+            if (i < n)
+            {
+                local(i);
+                continue;
+            }
+
+            // Own deque is empty: steal the back half of the fullest victim.
+            // Work is only ever moved, never created, so once every deque
+            // looks empty the rest is held by workers that will finish it.
+            unsigned victim = self;
+            size_t most = 0;
+            for (unsigned w = 0; w < threads; w++)
+            {
+                std::lock_guard<std::mutex> guard(deques[w].lock);
+                if (w != self && deques[w].end - deques[w].begin > most)
+                    victim = w, most = deques[w].end - deques[w].begin;
+            }
+            if (victim == self)
+                return;
+            size_t first, last;
+            {
+                std::lock_guard<std::mutex> guard(deques[victim].lock);
+                size_t left = deques[victim].end - deques[victim].begin;
+                if (left == 0)
+                    continue; // Drained in the meantime, look again
+                last = deques[victim].end;
+                first = last - (left + 1) / 2;
+                deques[victim].end = first;
+            }
+            std::lock_guard<std::mutex> guard(mine.lock);
+            mine.begin = first, mine.end = last;
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned w = 1; w < threads; w++)
+        pool.emplace_back(worker, w);
+    worker(0);
+    for (auto &t : pool)
+        t.join();
+}
+
+// Decide accepts(line) for every line of `path` on `threads` workers. Lines
+// are read and decided in blocks, and each block's verdicts are written in
+// input order. accepts returns a bool, or a verdict code as in LBAVerdict
+// (lba.h): 0 reject, 1 accept, 2 loops, 3 step limit. An empty line is the
+// empty string; a trailing '\r' is dropped. Returns the process exit code.
+template <class Accepts>
+int runBatch(const std::string &path, Accepts accepts, unsigned threads = 1)
+{
+    std::ifstream file;
+    if (path != "-")
+    {
+        file.open(path);
+        if (!file)
+        {
+            std::cerr << "Cannot open " << path << "\n";
+            return 1;
+        }
+    }
+    std::istream &in = path == "-" ? std::cin : file;
+    std::ios::sync_with_stdio(false);
+
+    const size_t blockSize = 1 << 16;
+    std::vector<std::string> lines(blockSize);
+    std::vector<char> verdicts(blockSize);
+    std::string out;
+    size_t inputs = 0, bytes = 0, accepted = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (in)
+    {
+        size_t count = 0;
+        while (count < blockSize && std::getline(in, lines[count]))
+        {
+            std::string &line = lines[count++];
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            bytes += line.size();
+        }
+
+        parallelFor(count, threads, [&, accepts](size_t i) mutable { verdicts[i] = accepts(lines[i]); });
+
+        static const char *const verdictLines[] = {"reject\n", "accept\n", "loops\n", "step-limit\n"};
+        out.clear();
+        for (size_t i = 0; i < count; i++)
+        {
+            out += verdictLines[(int)verdicts[i]];
+            accepted += verdicts[i] == 1;
+        }
+        std::cout << out;
+        inputs += count;
+    }
+    std::cout.flush();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    char report[256];
+    std::snprintf(report, sizeof report,
+                  "%zu inputs (%zu accepted), %zu bytes in %.3f s on %u threads: %.0f inputs/s, %.0f bytes/s\n",
+                  inputs, accepted, bytes, seconds, threads,
+                  seconds > 0 ? inputs / seconds : 0.0, seconds > 0 ? bytes / seconds : 0.0);
+    std::cerr << report;
+    return 0;
+}
@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+# Compare two bench JSON files and flag regressions of CURRENT against BASELINE.
+#   bench-compare.py BASELINE CURRENT [--time 0.15] [--allocs 0.01] [--rss 0.20]
+# A case regresses when its ns/op, allocations/op or peak RSS grows by more
+# than the given fraction, or when its output (the result the case computes)
+# changes. Exits 1 if any case regressed or failed, so it can
+# gate a build; cases present in only one file are listed but not fatal.
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        return {b["name"]: b for b in json.load(f)["benchmarks"]}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Flag benchmark regressions against a stored baseline")
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--time", type=float, default=0.15, help="allowed ns/op growth (fraction)")
+    parser.add_argument("--allocs", type=float, default=0.01, help="allowed allocations/op growth (fraction)")
+    parser.add_argument("--rss", type=float, default=0.20, help="allowed peak RSS growth (fraction)")
+    args = parser.parse_args()
+
+    baseline, current = load(args.baseline), load(args.current)
+    metrics = [("ns_per_op", args.time), ("allocs_per_op", args.allocs), ("peak_rss_bytes", args.rss)]
+    regressions = 0
+
+    print(f"{'case':48} {'ns/op':>9} {'allocs/op':>10} {'peak RSS':>9}")
+    for name, now in current.items():
+        before = baseline.get(name)
+        if "error" in now:
+            print(f"{name:48} FAILED: {now['error']}")
+            regressions += 1
+            continue
+        if before is None or "error" in before:
+            print(f"{name:48} (not in the baseline)")
+            continue
+        cells, flagged = [], False
+        for metric, allowed in metrics:
+            old, new = before[metric], now[metric]
+            change = (new - old) / old if old else (1.0 if new else 0.0)
+            worse = change > allowed
+            flagged |= worse
+            cells.append(f"{change:+.1%}" + ("!" if worse else " "))
+        if before.get("output") != now.get("output"):
+            cells.append(f"output {before.get('output')} -> {now.get('output')}!")
+            flagged = True
+        print(f"{name:48} {cells[0]:>9} {cells[1]:>10} {cells[2]:>9} {' '.join(cells[3:])}")
+        regressions += flagged
+
+    for name in sorted(baseline.keys() - current.keys()):
+        print(f"{name:48} (not in the current run)")
+
+    if regressions:
+        print(f"\n{regressions} regression(s) ('!' marks the metrics over the threshold and changed outputs)")
+        return 1
+    print("\nNo regressions")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,342 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "batch.h"
+#include "cfg.h"
+#include "gll.h"
+#include "ll1.h"
+#include "lalr.h"
+#include "lba.h"
+#include "cnf.h"
+#include "gnf.h"
+#include "generate.h"
+using namespace std;
+
+// Benchmarks for the recognizers and the normal form conversions over
+// parameterized workloads. Every case runs in a forked child, so its peak RSS
+// is its own; results are written as one JSON document for bench-compare.py.
+//   bench [--filter TEXT] [--max-n N] [--min-time SECONDS] [--out FILE]
+//   bench --list
+// A case name is engine/workload/n; --filter keeps the names containing TEXT
+// and --max-n drops the larger sizes.
+
+// Heap traffic, counted by the replaced global operator new. The benchmarks
+// are single-threaded, so plain counters do. The replacements stay out of
+// line, or GCC flags the inlined free() of new'd memory.
+size_t allocations = 0, allocatedBytes = 0;
+
+[[gnu::noinline]] void *operator new(size_t bytes)
+{
+    allocations++;
+    allocatedBytes += bytes;
+    if (void *p = malloc(bytes ? bytes : 1))
+        return p;
+    throw bad_alloc();
+}
+[[gnu::noinline]] void operator delete(void *p) noexcept { free(p); }
+[[gnu::noinline]] void operator delete(void *p, size_t) noexcept { free(p); }
+
+// One benchmark case: setup builds the input once, op is what gets timed. op
+// returns a size the case reports as "output" (1/0 for an accept/reject,
+// the production count for a conversion), so a change in the work done
+// shows up next to the change in time.
+struct Case
+{
+    string engine, workload;
+    size_t n;
+    function<function<size_t()>()> setup;
+    string name() const { return engine + "/" + workload + "/" + to_string(n); }
+};
+
+// Indirect left recursion `depth` variables deep:
+//   S → N1 a0 | b0,  Ni → Ni+1 ai | bi,  Nd-1 → S ad-1 | bd-1
+Grammar leftRecursiveGrammar(size_t depth)
+{
+    vector<pair<string, vector<vector<string>>>> rules;
+    for (size_t i = 0; i < depth; i++)
+    {
+        string self = i ? "N" + to_string(i) : "S", next = i + 1 < depth ? "N" + to_string(i + 1) : "S";
+        rules.push_back({self, {{next, "a" + to_string(i)}, {"b" + to_string(i)}}});
+    }
+    return makeGrammar("S", rules);
+}
+
+// The conversions as cnf2/gnf2/cfgc run them, on a fresh copy of G
+size_t toCNF(Grammar G)
+{
+    convertToCNF(G);
+    return G.productionCount();
+}
+
+size_t toGNF(Grammar G, bool matrix)
+{
+    removeUselessSymbols(G);
+    removeEpsilons(G);
+    removeUselessSymbols(G);
+    removeUnits(G);
+    removeUselessSymbols(G);
+    // The substitution method can grow exponentially: give up past a
+    // million rules for one variable and report 0
+    if (matrix)
+        convertToGNFMatrix(G);
+    else if (!convertToGNF(G, 1000000))
+        return 0;
+    return G.productionCount();
+}
+
+// Decider for a^n b^n followed by an end marker $, which the machine needs
+// because running off the right end of the tape rejects. q0 marks the first
+// unmarked a as X, q1 marks the first unmarked b as Y, q2 returns; once no a
+// is left, q4 checks that only Y's precede the $.
+LBATransitions anbnMachine = {
+    {{"q0", 'X'}, {"q0", 'X', 'R'}},
+    {{"q0", 'a'}, {"q1", 'X', 'R'}},
+    {{"q0", 'Y'}, {"q4", 'Y', 'R'}},
+
+    {{"q1", 'a'}, {"q1", 'a', 'R'}},
+    {{"q1", 'Y'}, {"q1", 'Y', 'R'}},
+    {{"q1", 'b'}, {"q2", 'Y', 'L'}},
+
+    {{"q2", 'a'}, {"q2", 'a', 'L'}},
+    {{"q2", 'Y'}, {"q2", 'Y', 'L'}},
+    {{"q2", 'X'}, {"q0", 'X', 'R'}},
+
+    {{"q4", 'Y'}, {"q4", 'Y', 'R'}},
+    {{"q4", '$'}, {"q3", '$', 'S'}},
+};
+
+vector<Case> allCases()
+{
+    CharGrammar anbn = {{'S', {"aSb", "ab"}}};
+    CharGrammar leftRecursive = {{'S', {"Sa", "a"}}};
+    CharGrammar anbnFactored = {{'S', {"aT"}}, {'T', {"Sb", "b"}}}; // LL(1)
+    auto anbnInput = [](size_t n) { return string(n, 'a') + string(n, 'b'); };
+    vector<Case> cases;
+
+    // The breadth-first search copies every sentential form and the LBA
+    // crosses the tape once per pair, so both are quadratic in n and stop at
+    // 10^4
+    for (size_t n : {10, 100, 1000, 10000, 100000})
+    {
+        if (n <= 10000)
+            cases.push_back({"simulateCFG", "anbn", n, [=] {
+                                 string input = anbnInput(n);
+                                 return function<size_t()>([=] { return simulateCFG(input, anbn, false); });
+                             }});
+        cases.push_back({"simulateCFGtoPDA", "anbn", n, [=] {
+                             auto G = make_shared<Slots>(compileSlots(anbn));
+                             string input = anbnInput(n);
+                             return function<size_t()>([=] { return simulateCFGtoPDA(input, *G, false); });
+                         }});
+        cases.push_back({"ll1Parse", "anbn", n, [=] {
+                             auto T = make_shared<LL1Table>(compileLL1(anbnFactored));
+                             auto stack = make_shared<vector<uint16_t>>();
+                             string input = anbnInput(n);
+                             return function<size_t()>([=] { return ll1Parse(*T, input, *stack); });
+                         }});
+        cases.push_back({"lalrRecognize", "anbn", n, [=] {
+                             auto T = make_shared<LALRTables>(compileLALR(fromCharGrammar(anbn)));
+                             auto stack = make_shared<vector<uint32_t>>();
+                             string input = anbnInput(n);
+                             return function<size_t()>([=] { return lalrRecognize(*T, input, *stack); });
+                         }});
+        if (n <= 10000)
+            cases.push_back({"simulateLBA", "anbn", n, [=] {
+                                 auto T = make_shared<LBATable>(compileLBA(anbnMachine, "q0", "q3"));
+                                 string input = anbnInput(n) + "$";
+                                 return function<size_t()>([=] { return simulateLBA(*T, input) == Accepts; });
+                             }});
+    }
+    for (size_t n : {10, 100, 1000, 10000, 100000})
+    {
+        if (n <= 10000)
+            cases.push_back({"simulateCFG", "left-recursion", n, [=] {
+                                 string input(n, 'a');
+                                 return function<size_t()>([=] { return simulateCFG(input, leftRecursive, false); });
+                             }});
+        cases.push_back({"simulateCFGtoPDA", "left-recursion", n, [=] {
+                             auto G = make_shared<Slots>(compileSlots(leftRecursive));
+                             string input(n, 'a');
+                             return function<size_t()>([=] { return simulateCFGtoPDA(input, *G, false); });
+                         }});
+        cases.push_back({"lalrRecognize", "left-recursion", n, [=] {
+                             auto T = make_shared<LALRTables>(compileLALR(fromCharGrammar(leftRecursive)));
+                             auto stack = make_shared<vector<uint32_t>>();
+                             string input(n, 'a');
+                             return function<size_t()>([=] { return lalrRecognize(*T, input, *stack); });
+                         }});
+    }
+
+    // Conversions: random grammars of growing size (n variables, 3n
+    // productions, see generate.h), deep left recursion
+    auto random = [](size_t n) {
+        GrammarShape shape;
+        shape.variables = n;
+        shape.productions = 3 * n;
+        return randomGrammar(shape, n);
+    };
+    for (size_t n : {8, 32, 128, 512})
+    {
+        cases.push_back({"convertToCNF", "random", n, [=] {
+                             Grammar G = random(n);
+                             return function<size_t()>([=] { return toCNF(G); });
+                         }});
+        cases.push_back({"convertToGNF", "random", n, [=] {
+                             Grammar G = random(n);
+                             return function<size_t()>([=] { return toGNF(G, false); });
+                         }});
+        cases.push_back({"convertToGNFMatrix", "random", n, [=] {
+                             Grammar G = random(n);
+                             return function<size_t()>([=] { return toGNF(G, true); });
+                         }});
+    }
+    for (size_t n : {8, 32, 128, 512})
+    {
+        cases.push_back({"convertToCNF", "left-recursion", n, [=] {
+                             Grammar G = leftRecursiveGrammar(n);
+                             return function<size_t()>([=] { return toCNF(G); });
+                         }});
+        cases.push_back({"convertToGNF", "left-recursion", n, [=] {
+                             Grammar G = leftRecursiveGrammar(n);
+                             return function<size_t()>([=] { return toGNF(G, false); });
+                         }});
+        cases.push_back({"convertToGNFMatrix", "left-recursion", n, [=] {
+                             Grammar G = leftRecursiveGrammar(n);
+                             return function<size_t()>([=] { return toGNF(G, true); });
+                         }});
+    }
+    return cases;
+}
+
+// Peak resident set size of this process so far, in bytes
+size_t peakRSS()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss; // Bytes on macOS, kilobytes on Linux
+#else
+    return (size_t)usage.ru_maxrss * 1024;
+#endif
+}
+
+// Time one case and return its JSON object. After a warm-up call, batches
+// are sized to take about minTime / 3 each; ns/op is the median of three
+// batches, allocations and bytes are per call.
+string measure(const Case &c, double minTime)
+{
+    function<size_t()> op = c.setup();
+    using clock = chrono::steady_clock;
+    auto start = clock::now();
+    size_t output = op();
+    double once = chrono::duration<double>(clock::now() - start).count();
+    size_t iterations = max<size_t>(1, (size_t)(minTime / 3 / max(once, 1e-9)));
+
+    vector<double> perOp;
+    size_t allocs = allocations, bytes = allocatedBytes;
+    for (int batch = 0; batch < 3; batch++)
+    {
+        start = clock::now();
+        for (size_t i = 0; i < iterations; i++)
+            op();
+        perOp.push_back(chrono::duration<double, nano>(clock::now() - start).count() / iterations);
+    }
+    sort(perOp.begin(), perOp.end());
+    double calls = 3.0 * iterations;
+
+    ostringstream json;
+    json << "{\"name\": \"" << c.name() << "\", \"engine\": \"" << c.engine << "\", \"workload\": \""
+         << c.workload << "\", \"n\": " << c.n << ", \"iterations\": " << (size_t)calls
+         << ", \"ns_per_op\": " << (size_t)perOp[1] << ", \"allocs_per_op\": " << (allocations - allocs) / calls
+         << ", \"bytes_per_op\": " << (size_t)((allocatedBytes - bytes) / calls)
+         << ", \"peak_rss_bytes\": " << peakRSS() << ", \"output\": " << output << "}";
+    return json.str();
+}
+
+// Run a case in a child process and read its JSON object back through a pipe
+string measureInChild(const Case &c, double minTime)
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+        return "";
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        close(fds[0]);
+        close(fds[1]);
+        return "{\"name\": \"" + c.name() + "\", \"error\": \"cannot fork\"}";
+    }
+    if (pid == 0)
+    {
+        close(fds[0]);
+        string json = measure(c, minTime);
+        ssize_t written = write(fds[1], json.data(), json.size());
+        _exit(written == (ssize_t)json.size() ? 0 : 1);
+    }
+    close(fds[1]);
+    string json;
+    char buffer[4096];
+    for (ssize_t got; (got = read(fds[0], buffer, sizeof buffer)) > 0;)
+        json.append(buffer, got);
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        return "{\"name\": \"" + c.name() + "\", \"error\": \"the benchmark process failed\"}";
+    return json;
+}
+
+int main(int argc, char *argv[])
+{
+    vector<Case> cases = allCases();
+    if (hasFlag(argc, argv, "--list"))
+    {
+        for (auto &c : cases)
+            cout << c.name() << "\n";
+        return 0;
+    }
+
+    string filter = flagText(argc, argv, "--filter");
+    size_t maxN = flagValue(argc, argv, "--max-n", SIZE_MAX);
+    double minTime = stod(flagText(argc, argv, "--min-time", "0.3"));
+    string outPath = flagText(argc, argv, "--out");
+
+    vector<string> results;
+    for (auto &c : cases)
+    {
+        if (c.n > maxN || c.name().find(filter) == string::npos)
+            continue;
+        cerr << c.name() << "... " << flush;
+        results.push_back(measureInChild(c, minTime));
+        cerr << "done" << endl;
+    }
+
+    ofstream file;
+    if (!outPath.empty())
+    {
+        file.open(outPath);
+        if (!file)
+        {
+            cerr << "Cannot write " << outPath << endl;
+            return 1;
+        }
+    }
+    ostream &out = outPath.empty() ? cout : file;
+    out << "{\"benchmarks\": [\n";
+    for (size_t k = 0; k < results.size(); k++)
+        out << "  " << results[k] << (k + 1 < results.size() ? ",\n" : "\n");
+    out << "]}\n";
+    return 0;
+}
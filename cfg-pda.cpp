@@ -1,86 +1,59 @@
 #include <iostream>
-#include <stack>
-#include <queue>
 #include <unordered_map>
 #include <vector>
 #include <string>
+#include "batch.h"
+#include "gll.h"
+#include "ll1.h"
 using namespace std;
 
-// Structure for PDA configuration
-struct Config
+int main(int argc, char *argv[])
 {
-    string stackContent; // Current stack as string (top at back)
-    int inputIndex;      // Current position in input
-    string path;         // Transition path for output
-};
-
-bool simulateCFGtoPDA(const string &input, unordered_map<char, vector<string>> &grammar)
-{
-    queue<Config> q;
-
-    // Start with stack = S (start symbol)
-    q.push({"S", 0, "[S]"});
-
-    while (!q.empty())
+    // Example CFG: S -> aSb | ab
+    unordered_map<char, vector<string>> grammar;
+    grammar['S'] = {"aSb", "ab"};
+    // --stats FILE: one JSON line of search counters per query (see stats.h)
+    if (!openStats(argc, argv))
+        return 1;
+
+    // An LL(1) grammar is parsed by the predictive parser (ll1.h), anything
+    // else by the GLL search; --gll forces the search
+    LL1Table table = compileLL1(grammar);
+    bool predictive = table.isLL1() && !hasFlag(argc, argv, "--gll");
+
+    // --batch [file] [--threads N]: decide every line of the file (or stdin), no traces
+    string batchPath;
+    if (batchRequested(argc, argv, batchPath))
     {
-        Config current = q.front();
-        q.pop();
-
-        // Accept if stack empty and input fully read
-        if (current.stackContent.empty() && current.inputIndex == input.size())
-        {
-            cout << "\nString accepted!\nTransitions:\n";
-            cout << current.path << "\n";
-            return true;
-        }
-
-        // Skip invalid paths
-        if (current.stackContent.empty() || current.inputIndex > input.size())
-            continue;
-
-        char top = current.stackContent.back();
-        string remainingStack = current.stackContent.substr(0, current.stackContent.size() - 1);
-
-        // If top is non-terminal, expand using CFG productions
-        if (grammar.count(top))
-        {
-            for (auto &prod : grammar[top])
-            {
-                // Push production in **reverse order** onto stack
-                string newStack = remainingStack;
-                for (int i = prod.size() - 1; i >= 0; --i)
-                    newStack += prod[i];
-
-                string newPath = current.path + " -> [" + newStack + "]";
-                q.push({newStack, current.inputIndex, newPath});
-            }
-        }
-        // If top is terminal, match with input
-        else
-        {
-            if (current.inputIndex < input.size() && top == input[current.inputIndex])
-            {
-                string newPath = current.path + " -> [" + remainingStack + "]";
-                q.push({remainingStack, current.inputIndex + 1, newPath});
-            }
-        }
+        if (predictive)
+            return runBatch(batchPath, [&](const string &s) {
+                thread_local vector<uint16_t> stack;
+                return ll1Parse(table, s, stack);
+            }, batchThreads(argc, argv));
+        Slots compiled = compileSlots(grammar);
+        return runBatch(batchPath, [&](const string &s) { return simulateCFGtoPDA(s, compiled, false); },
+                        batchThreads(argc, argv));
     }
 
-    cout << "\nString rejected!\n";
-    return false;
-}
-
-int main()
-{
     cout << "\nCFG to PDA\n";
-    // Example CFG: S -> aSb | ab
-    unordered_map<char, vector<string>> grammar;
-    grammar['S'] = {"aSb", "ab"};
 
     cout << "Example CFG: S -> aSb | ab\n";
+    if (table.isLL1())
+        cout << "The grammar is LL(1)" << (predictive ? ": predictive parsing\n" : "\n");
+    else
+    {
+        cout << "Not LL(1), conflicts:\n";
+        printLL1Conflicts(cout, table);
+    }
     string input;
     cout << "\nEnter a string to test: ";
     cin >> input;
 
-    simulateCFGtoPDA(input, grammar);
+    if (predictive)
+    {
+        vector<uint16_t> stack;
+        ll1Parse(table, input, stack, true);
+    }
+    else
+        simulateCFGtoPDA(input, compileSlots(grammar));
 }
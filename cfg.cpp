@@ -1,87 +1,106 @@
 #include <iostream>
 #include <vector>
-#include <queue>
 #include <unordered_map>
 #include <string>
+#include "batch.h"
+#include "cfg.h"
+#include "earley.h"
+#include "lalr.h"
 using namespace std;
 
-bool simulateCFG(const string &input)
-{
-    // Step 1: Define the grammar rules
-    unordered_map<char, vector<string>> grammar;
-    grammar['S'] = {"aSb", "ab"}; // Non-terminal S → aSb | ab
-
-    // Step 2: Initialize a BFS queue
-    // Each queue element stores:
-    //   - current derived string
-    //   - list of derivation steps leading to it
-    queue<pair<string, vector<string>>> q;
+// Context-free grammar simulator: decides strings with the LALR(1)
+// shift-reduce recognizer (lalr.h) when the grammar is deterministic, else
+// with the breadth-first derivation search (cfg.h).
+//   cfg [--earley | --bfs | --artifact FILE] [--batch [file] [--threads N]] [--stats FILE]
 
-    // Start with the start symbol 'S'
-    q.push({"S", {"S"}});
+// Step 1: Define the grammar rules
+CharGrammar grammar = {
+    {'S', {"aSb", "ab"}}, // Non-terminal S → aSb | ab
+};
 
-    // Step counter for readability (not functionally used)
-    int step = 1;
+int main(int argc, char *argv[])
+{
+    // --earley: decide membership with the Earley recognizer instead of BFS
+    bool useEarley = hasFlag(argc, argv, "--earley");
+    // --bfs: search derivations even when the grammar is LALR(1)
+    bool useBFS = hasFlag(argc, argv, "--bfs");
+    // --stats FILE: one JSON line of search counters per query (see stats.h)
+    if (!openStats(argc, argv))
+        return 1;
 
-    // Step 3: Begin BFS to explore all possible derivations
-    while (!q.empty())
+    // --artifact FILE: take the LALR tables from a precompiled artifact
+    // (cfgc --lalr) instead of building them at startup
+    string artifactPath = flagText(argc, argv, "--artifact");
+    Artifact artifact;
+    GrammarView view;
+    Grammar G;
+    LALRTables T;
+    if (!artifactPath.empty())
     {
-        auto [current, steps] = q.front();
-        q.pop();
-
-        // Step 4: If the current string exactly matches the input,
-        // the string is accepted by the grammar.
-        if (current == input)
+        // The artifact holds only the LALR tables: the search engines work on
+        // the built-in grammar, so they cannot decide the artifact's language
+        if (useEarley || useBFS)
         {
-            cout << "\n✅ String accepted!\n";
-            cout << "Derivation steps:\n";
-            for (int i = 0; i < steps.size(); i++)
-            {
-                cout << "Step " << i + 1 << ": " << steps[i] << endl;
-            }
-            return true;
+            cerr << "--artifact takes the LALR tables and cannot be combined with --earley or --bfs" << endl;
+            return 1;
         }
-
-        // Step 5: Avoid expanding if the current string already exceeds
-        // the input's length (to prevent unnecessary expansions)
-        if (current.size() > input.size())
-            continue;
-
-        // Step 6: Find and expand the first non-terminal symbol (A–Z)
-        for (int i = 0; i < current.size(); i++)
+        if (!artifact.open(artifactPath))
         {
-            char symbol = current[i];
-            if (isupper(symbol))
-            {
-                // For each production rule of this non-terminal
-                for (string prod : grammar[symbol])
-                {
-                    // Replace the non-terminal with the production
-                    string next = current.substr(0, i) + prod + current.substr(i + 1);
-
-                    // Record this derivation step for output
-                    auto newSteps = steps;
-                    newSteps.push_back(next);
-
-                    // Add the new derived string to the queue for further expansion
-                    q.push({next, newSteps});
-                }
-                // Expand only one non-terminal at a time (leftmost derivation)
-                break;
-            }
+            cerr << artifact.error << endl;
+            return 1;
+        }
+        if (!viewGrammar(artifact, view) || !viewLALRTables(artifact, T))
+        {
+            cerr << artifactPath << " does not hold a grammar with LALR tables" << endl;
+            return 1;
         }
     }
+    else
+    {
+        G = fromCharGrammar(grammar);
+        T = compileLALR(G);
+    }
+    bool useLALR = !useEarley && !useBFS && T.deterministic();
 
-    // Step 7: If BFS finishes and no match is found, reject the string
-    cout << "\n❌ String rejected. Cannot be derived from the grammar.\n";
-    return false;
-}
+    // --batch [file] [--threads N]: decide every line of the file (or stdin), no traces
+    string batchPath;
+    if (batchRequested(argc, argv, batchPath))
+    {
+        if (useEarley)
+        {
+            EarleyGrammar compiled = compileEarley(grammar);
+            return runBatch(batchPath, [&](const string &s) { return earleyRecognize(compiled, s); },
+                            batchThreads(argc, argv));
+        }
+        if (useLALR)
+            return runBatch(batchPath,
+                            [&](const string &s) {
+                                thread_local vector<uint32_t> stack;
+                                return lalrRecognize(T, s, stack);
+                            },
+                            batchThreads(argc, argv));
+        return runBatch(batchPath, [](const string &s) { return simulateCFG(s, grammar, false); },
+                        batchThreads(argc, argv));
+    }
 
-int main()
-{
     cout << "\nContext-Free Grammar Simulator\n";
     cout << "Grammar: ";
-    cout << "S → aSb | ab\n\n";
+    if (artifactPath.empty())
+        cout << "S → aSb | ab\n\n";
+    else
+    {
+        cout << "\n";
+        printRules(view);
+        cout << "\n";
+    }
+    // Conflicts are only known for tables built in-process: cfgc --lalr
+    // refuses to store tables that have any
+    if (artifactPath.empty() && !useEarley && !useBFS && !T.deterministic())
+    {
+        cout << "Not LALR(1), conflicts:\n";
+        printLALRConflicts(cout, G, T);
+        cout << "\n";
+    }
 
     // Step 8: Get input string from user
     string input;
@@ -89,7 +108,26 @@ int main()
     cin >> input;
 
     // Step 9: Run the CFG simulation
-    simulateCFG(input);
+    if (useEarley)
+        cout << (earleyRecognize(compileEarley(grammar), input) ? "\n✅ String accepted!\n"
+                                                                 : "\n❌ String rejected.\n");
+    else if (useLALR)
+    {
+        vector<uint32_t> stack, reductions;
+        if (!lalrRecognize(T, input, stack, &reductions))
+        {
+            cout << "\n❌ String rejected. Cannot be derived from the grammar.\n";
+            return 0;
+        }
+        vector<string> steps =
+            artifactPath.empty() ? rightmostDerivation(G, reductions) : rightmostDerivation(view, reductions);
+        cout << "\n✅ String accepted!\n";
+        cout << "Derivation steps:\n";
+        for (size_t i = 0; i < steps.size(); i++)
+            cout << "Step " << i + 1 << ": " << steps[i] << endl;
+    }
+    else
+        simulateCFG(input, grammar);
 
     return 0;
 }
@@ -0,0 +1,205 @@
+#pragma once
+// Breadth-first derivation search for the char-keyed grammars of cfg.cpp
+// (unordered_map<char, vector<string>>, a key is a nonterminal, 'S' starts).
+// Sentential forms are expanded leftmost; forms already reached, forms whose
+// terminal prefix disagrees with the input and forms that can only derive
+// longer strings are dropped.
+#include <climits>
+#include <cstdint>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "stats.h"
+
+using CharGrammar = std::unordered_map<char, std::vector<std::string>>;
+
+// Minimum number of terminals each non-terminal can derive (INT_MAX if it
+// derives no terminal string at all), computed by relaxing every rule until
+// nothing improves
+inline std::unordered_map<char, int> minimumYields(const CharGrammar &grammar)
+{
+    std::unordered_map<char, int> yield;
+    for (auto &[A, _] : grammar)
+        yield[A] = INT_MAX;
+
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (auto &[A, prods] : grammar)
+            for (const std::string &prod : prods)
+            {
+                long long total = 0;
+                for (char c : prod)
+                    total += isupper(c) ? (yield.count(c) ? yield[c] : INT_MAX) : 1;
+                if (total < yield[A])
+                {
+                    yield[A] = (int)total;
+                    changed = true;
+                }
+            }
+    }
+    return yield;
+}
+
+// 64-bit FNV-1a hash of a sentential form
+inline uint64_t formHash(const std::string &form)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (char c : form)
+        h = (h ^ (unsigned char)c) * 0x100000001b3ULL;
+    return h;
+}
+
+// Derivation arena entry: how a queued form was derived from its parent.
+// Full derivations are only rebuilt from these when a string is accepted.
+struct DerivationNode
+{
+    int parent;                    // Arena index of the parent form, -1 for S
+    int position;                  // Index of the non-terminal that was replaced
+    const std::string *production; // Production substituted for it
+};
+
+// Replay the chain of arena entries ending at `node`, starting from S
+inline std::vector<std::string> rebuildDerivation(const std::vector<DerivationNode> &arena, int node)
+{
+    std::vector<int> chain;
+    for (; node >= 0; node = arena[node].parent)
+        chain.push_back(node);
+
+    std::vector<std::string> steps = {"S"};
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+    {
+        const DerivationNode &d = arena[*it];
+        const std::string &form = steps.back();
+        steps.push_back(form.substr(0, d.position) + *d.production + form.substr(d.position + 1));
+    }
+    return steps;
+}
+
+// With trace = false nothing is recorded or printed: a pure yes/no check
+inline bool simulateCFG(const std::string &input, const CharGrammar &grammar, bool trace = true)
+{
+    QueryStats stats("simulateCFG", input.size());
+
+    // Lower bound on the length of any string derivable from each non-terminal
+    std::unordered_map<char, int> yield = minimumYields(grammar);
+
+    // Hashes of sentential forms already queued; a hash collision could only
+    // drop a form, never accept a string that is not in the language
+    std::unordered_set<uint64_t> visited;
+
+    // Step 2: Initialize a BFS queue
+    // Each queue element stores:
+    //   - current derived string
+    //   - arena index of the step that produced it (-1 when not tracing)
+    std::queue<std::pair<std::string, int>> q;
+    std::vector<DerivationNode> arena;
+
+    // Start with the start symbol 'S'
+    q.push({"S", -1});
+    stats.rise(FrontierBytes, 1);
+    stats.phase(Search);
+
+    // Step 3: Begin BFS to explore all possible derivations
+    while (!q.empty())
+    {
+        auto [current, node] = q.front();
+        q.pop();
+        stats.add(Expanded);
+        stats.fall(FrontierBytes, current.size());
+        stats.sample(FormLength, current.size());
+
+        // Step 4: If the current string exactly matches the input,
+        // the string is accepted by the grammar.
+        if (current == input)
+        {
+            if (!trace)
+                return stats.result(true);
+            stats.phase(Replay);
+            std::vector<std::string> steps = rebuildDerivation(arena, node);
+            std::cout << "\n✅ String accepted!\n";
+            std::cout << "Derivation steps:\n";
+            for (size_t i = 0; i < steps.size(); i++)
+            {
+                std::cout << "Step " << i + 1 << ": " << steps[i] << std::endl;
+            }
+            return stats.result(true);
+        }
+
+        // Step 5: Avoid expanding forms that can no longer derive the input:
+        //   - the terminals before the first non-terminal are final in a
+        //     leftmost derivation, so they must match the start of the input;
+        //   - every terminal plus the minimum yield of every non-terminal must
+        //     still fit into the input's length
+        size_t prefix = 0;
+        while (prefix < current.size() && !isupper(current[prefix]))
+        {
+            if (prefix >= input.size() || current[prefix] != input[prefix])
+                break;
+            prefix++;
+        }
+        if (prefix < current.size() && !isupper(current[prefix]))
+        {
+            stats.add(Pruned);
+            continue;
+        }
+
+        long long minLength = 0;
+        for (char c : current)
+            minLength += isupper(c) ? (yield.count(c) ? yield[c] : INT_MAX) : 1;
+        if (minLength > (long long)input.size())
+        {
+            stats.add(Pruned);
+            continue;
+        }
+
+        // Step 6: Find and expand the first non-terminal symbol (A–Z)
+        for (size_t i = 0; i < current.size(); i++)
+        {
+            char symbol = current[i];
+            if (isupper(symbol))
+            {
+                // For each production rule of this non-terminal
+                for (const std::string &prod : grammar.at(symbol))
+                {
+                    // Replace the non-terminal with the production
+                    std::string next = current.substr(0, i) + prod + current.substr(i + 1);
+
+                    // Skip forms that were already reached by another derivation
+                    stats.add(Generated);
+                    if (!visited.insert(formHash(next)).second)
+                    {
+                        stats.add(Duplicates);
+                        continue;
+                    }
+
+                    // Record this derivation step in the arena
+                    int child = -1;
+                    if (trace)
+                    {
+                        child = arena.size();
+                        arena.push_back({node, (int)i, &prod});
+                    }
+
+                    // Add the new derived string to the queue for further expansion
+                    q.push({next, child});
+                    stats.peak(FrontierPeak, q.size());
+                    stats.rise(FrontierBytes, next.size());
+                    stats.peak(ArenaBytes, arena.size() * sizeof(DerivationNode) + visited.size() * sizeof(uint64_t));
+                }
+                // Expand only one non-terminal at a time (leftmost derivation)
+                break;
+            }
+        }
+    }
+
+    // Step 7: If BFS finishes and no match is found, reject the string
+    if (trace)
+        std::cout << "\n❌ String rejected. Cannot be derived from the grammar.\n";
+    return stats.result(false);
+}
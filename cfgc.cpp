@@ -0,0 +1,130 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <chrono>
+#include "artifact.h"
+#include "cnf.h"
+#include "gnf.h"
+#include "lalr.h"
+using namespace std;
+
+// Grammar compiler: normalizes a grammar once and writes the result as a
+// precompiled artifact (artifact.h) that cnf2/gnf2/cfg --artifact map at startup.
+//   cfgc --cnf GRAMMAR OUT   CNF grammar plus CYK tables
+//   cfgc --gnf GRAMMAR OUT   GNF grammar
+//   cfgc --gnf-matrix GRAMMAR OUT   GNF grammar, by the polynomial matrix method
+//   cfgc --lalr GRAMMAR OUT  the grammar as is plus LALR(1) tables; fails on conflicts
+//   cfgc --info ARTIFACT     verify an artifact, list its sections and rules
+// GRAMMAR is a rule file in the format printRules writes ("-" for stdin).
+
+int info(const string &path)
+{
+    Artifact artifact;
+    if (!artifact.open(path))
+    {
+        cerr << artifact.error << endl;
+        return 1;
+    }
+    const ArtifactHeader &h = artifact.header();
+    const char *kinds[] = {"plain", "CNF", "GNF"};
+    cout << path << ": version " << h.version << ", " << (h.kind < 3 ? kinds[h.kind] : "unknown") << " grammar, "
+         << h.fileSize << " bytes, checksum ok\n";
+    for (uint32_t s = 0; s < h.sections; s++)
+    {
+        const ArtifactSection &e = artifact.table()[s];
+        cout << "  section " << e.id << ": " << e.count << " x " << e.elemSize << " bytes at " << e.offset << "\n";
+    }
+    GrammarView G;
+    if (!viewGrammar(artifact, G))
+    {
+        cerr << "The grammar sections are missing or inconsistent" << endl;
+        return 1;
+    }
+    cout << G.symbolCount() << " symbols, " << G.productionCount() << " productions, start " << G.name(G.start)
+         << "\n";
+    printRules(G);
+    LALRTables T;
+    if (viewLALRTables(artifact, T))
+        cout << "LALR(1) tables: " << T.states << " states, " << T.columns << " columns, " << T.actionSize
+             << " ACTION and " << T.gotoSize << " GOTO entries\n";
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    string mode = argc > 1 ? argv[1] : "";
+    if (mode == "--info" && argc == 3)
+        return info(argv[2]);
+    if ((mode != "--cnf" && mode != "--gnf" && mode != "--gnf-matrix" && mode != "--lalr") || argc != 4)
+    {
+        cerr << "Usage: cfgc --cnf|--gnf|--gnf-matrix|--lalr GRAMMAR OUT\n       cfgc --info ARTIFACT\n";
+        return 1;
+    }
+
+    string path = argv[2], error;
+    ifstream file;
+    if (path != "-")
+    {
+        file.open(path);
+        if (!file)
+        {
+            cerr << "Cannot open " << path << endl;
+            return 1;
+        }
+    }
+    Grammar G;
+    if (!readGrammar(path == "-" ? cin : file, G, error))
+    {
+        cerr << path << ": " << error << endl;
+        return 1;
+    }
+
+    auto start = chrono::steady_clock::now();
+    ArtifactWriter out(mode == "--cnf" ? CNFGrammar : mode == "--lalr" ? PlainGrammar : GNFGrammar);
+    UselessReport useless;
+    if (mode == "--lalr")
+    {
+        // The tables must decide every step: a conflict would silently pick
+        // one action at run time, so refuse to store them
+        LALRTables T = compileLALR(G);
+        if (!T.deterministic())
+        {
+            cerr << path << ": not LALR(1), conflicts:\n";
+            printLALRConflicts(cerr, G, T);
+            return 1;
+        }
+        addGrammar(out, G);
+        addLALRTables(out, T);
+    }
+    else if (mode == "--cnf")
+    {
+        convertToCNF(G, &useless);
+        addGrammar(out, G);
+        addCNFTables(out, compileCNF(G));
+    }
+    else
+    {
+        useless += removeUselessSymbols(G);
+        removeEpsilons(G);
+        useless += removeUselessSymbols(G);
+        removeUnits(G);
+        useless += removeUselessSymbols(G);
+        if (mode == "--gnf-matrix")
+            convertToGNFMatrix(G);
+        else
+            convertToGNF(G);
+        useless += removeUselessSymbols(G);
+        addGrammar(out, G);
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    if (!out.save(argv[3]))
+    {
+        cerr << "Cannot write " << argv[3] << endl;
+        return 1;
+    }
+    cerr << G.symbolCount() << " symbols, " << G.productionCount() << " productions, converted in " << seconds
+         << " s\n";
+    printUselessReport(cerr, useless);
+    return 0;
+}
@@ -2,184 +2,95 @@
 #include <string>
 #include <map>
 #include <vector>
-#include <set>
 #include <algorithm>
-#include <cctype>
+#include <unordered_map>
+#include "grammar.h"
 using namespace std;
 
-// Structure representing a grammar
-struct Grammar
-{
-    string startSymbol;                        // Starting nonterminal (e.g., "S")
-    map<string, vector<vector<string>>> rules; // Each LHS → list of RHS vectors
-};
-
-// Check if symbol is terminal (lowercase letter)
-bool isTerminal(const string &s) { return s.size() == 1 && islower(s[0]); }
-
-// Check if symbol is nonterminal (uppercase letter)
-bool isNonTerminal(const string &s) { return s.size() == 1 && isupper(s[0]); }
-
 // Prints grammar in readable format
 void printGrammar(const Grammar &G, const string &title = "")
 {
     if (!title.empty())
         cout << "\n"
              << title << endl;
-    for (auto &[lhs, rhss] : G.rules)
-    {
-        cout << lhs << " → ";
-        for (size_t i = 0; i < rhss.size(); i++)
-        {
-            for (auto &sym : rhss[i])
-                cout << sym;
-            if (i != rhss.size() - 1)
-                cout << " | ";
-        }
-        cout << endl;
-    }
+    printRules(G);
 }
 
 // Step 1: Remove ε-Productions =====
+// A variable is nullable if it has a rule A → ε, or a rule whose symbols
+// are all nullable. Each rule gets a copy for every subset of nullable
+// symbols left out (A → aAS also gives A → aS), and the ε-rules go, except
+// for the start symbol.
 void removeEpsilonProductions(Grammar &G)
 {
-    set<string> nullable; // Stores variables that can derive ε
-
-    // Step 1: Identify nullable variables (A → ε)
-    for (auto &[lhs, rhsList] : G.rules)
-        for (auto &rhs : rhsList)
-            if (rhs.size() == 1 && rhs[0] == "ε")
-                nullable.insert(lhs);
-
-    // Step 2: For each nullable variable A, create new rules
-    for (auto &A : nullable)
-    {
-        for (auto &[lhs, rhsList] : G.rules)
-        {
-            vector<vector<string>> newRules;
-
-            // For each rule, try removing occurrences of A
-            for (auto rhs : rhsList)
-            {
-                for (size_t i = 0; i < rhs.size(); i++)
-                {
-                    if (rhs[i] == A && rhs.size() > 1)
-                    {
-                        vector<string> temp = rhs;
-                        temp.erase(temp.begin() + i); // Remove nullable symbol
-                        newRules.push_back(temp);     // Add modified rule
-                    }
-                }
-            }
-
-            // Add the newly formed rules
-            for (auto &r : newRules)
-                G.rules[lhs].push_back(r);
-        }
-
-        // Step 3: Remove ε directly from A's rules (except start symbol)
-        auto &v = G.rules[A];
-        v.erase(remove_if(v.begin(), v.end(),
-                          [](auto &r)
-                          { return r.size() == 1 && r[0] == "ε"; }),
-                v.end());
-    }
-
-    // Step 4: Keep ε only for start symbol if it was nullable
-    if (nullable.count(G.startSymbol))
-        G.rules[G.startSymbol].push_back({"ε"});
-
+    eliminateEpsilonRules(G);
     printGrammar(G, "Step 1: Remove ε-Productions");
 }
 
 // Step 2: Remove Unit Productions (A → B) =====
+// Variables on a cycle of unit rules are merged first; then A gets the
+// non-unit rules of every B it reaches through unit rules.
 void removeUnitProductions(Grammar &G)
 {
-    bool changed = true;
-
-    // Repeat until no unit rules remain
-    while (changed)
-    {
-        changed = false;
-
-        // Iterate through each nonterminal
-        for (auto &[lhs, rhsList] : G.rules)
-        {
-            vector<vector<string>> toAdd; // Rules to add from unit expansions
-
-            for (auto &rhs : rhsList)
-            {
-                // Identify unit productions (single uppercase symbol)
-                if (rhs.size() == 1 && isNonTerminal(rhs[0]))
-                {
-                    string B = rhs[0]; // Example: A → B
-                    // Add all rules from B into A
-                    for (auto &r2 : G.rules[B])
-                    {
-                        if (!(r2.size() == 1 && r2[0] == lhs))
-                        { // Avoid self-loop
-                            toAdd.push_back(r2);
-                            changed = true;
-                        }
-                    }
-                }
-            }
-
-            // Add expanded rules
-            rhsList.insert(rhsList.end(), toAdd.begin(), toAdd.end());
-
-            // Remove all direct unit productions (A → B)
-            rhsList.erase(remove_if(rhsList.begin(), rhsList.end(),
-                                    [](auto &r)
-                                    { return r.size() == 1 && isNonTerminal(r[0]); }),
-                          rhsList.end());
-        }
-    }
-
+    eliminateUnitRules(G);
     printGrammar(G, "Step 2: Remove Unit Productions");
 }
 
 // Step 3: Replace Terminals in Mixed RHS =====
 void replaceTerminalsInMixedRHS(Grammar &G)
 {
-    map<string, string> terminalMap; // Maps terminals to new variables (e.g., a → X1)
+    vector<Alternatives> rules = unpack(G);
+    vector<Symbol> rhs; // Scratch copy of the rule being rewritten
+    map<Symbol, Symbol> terminalMap; // Maps terminals to new variables (e.g., a → X1)
     int counter = 0;
 
     // Copy keys to avoid modifying while iterating
-    vector<string> nonterminals;
-    for (auto &[lhs, _] : G.rules)
-        nonterminals.push_back(lhs);
+    vector<Symbol> nonterminals = nonterminalsByName(G);
 
     // Iterate through all rules
-    for (auto &lhs : nonterminals)
+    for (Symbol lhs : nonterminals)
     {
-        for (auto &rhs : G.rules[lhs])
+        Alternatives replaced;
+        for (size_t k = 0; k < rules[lhs].size(); k++)
         {
+            rhs.assign(rules[lhs][k].begin(), rules[lhs][k].end());
             for (auto &sym : rhs)
             {
                 // Replace terminal if it appears with other symbols
-                if (isTerminal(sym) && rhs.size() > 1)
+                if (G.isTerminal(sym) && rhs.size() > 1)
                 {
                     if (!terminalMap.count(sym))
                     {
-                        // Create new variable for this terminal
-                        string newVar = "X" + to_string(++counter);
+                        // Create new variable for this terminal, skipping names the grammar uses
+                        string name;
+                        do
+                            name = "X" + to_string(++counter);
+                        while (G.symbols.contains(name));
+                        Symbol newVar = G.symbols.intern(name);
                         terminalMap[sym] = newVar;
-                        G.rules[newVar].push_back({sym}); // Add rule X1 → a
+                        rules.resize(G.symbols.size());
+                        rules[newVar].add({sym}); // Add rule X1 → a
                     }
                     sym = terminalMap[sym]; // Replace 'a' with 'X1'
                 }
             }
+            replaced.add(rhs);
         }
+        rules[lhs] = replaced;
     }
 
+    pack(G, rules);
     printGrammar(G, "Step 3: Replace Terminals in Mixed RHS");
 
     // Print summary of generated variables
     if (!terminalMap.empty())
     {
-        cout << "(Generated terminal variables: ";
+        vector<pair<string, string>> generated;
         for (auto &[t, var] : terminalMap)
+            generated.push_back({G.name(t), G.name(var)});
+        sort(generated.begin(), generated.end());
+        cout << "(Generated terminal variables: ";
+        for (auto &[t, var] : generated)
             cout << var << "=" << t << " ";
         cout << ")\n";
     }
@@ -188,70 +99,111 @@ void replaceTerminalsInMixedRHS(Grammar &G)
 // Step 4: Binarize Rules (Limit RHS to 2 Symbols) =====
 void binarizeGrammar(Grammar &G)
 {
+    vector<Alternatives> rules = unpack(G);
+    vector<Symbol> rhs; // Scratch copy of the rule being rewritten
     int binCount = 0; // Counter for new intermediate variables
-    vector<string> nonterminals;
+
+    // One variable per distinct pair (e.g., Y1 → C D), so rules that end
+    // the same way share their intermediate variables
+    unordered_map<uint64_t, Symbol> pairVars;
+    auto pairVar = [&](Symbol x, Symbol y)
+    {
+        auto [it, fresh] = pairVars.try_emplace((uint64_t)x << 32 | y, 0);
+        if (fresh)
+        {
+            string name;
+            do
+                name = "Y" + to_string(++binCount);
+            while (G.symbols.contains(name));
+            it->second = G.symbols.intern(name);
+            rules.resize(G.symbols.size());
+            rules[it->second].add({x, y});
+        }
+        return it->second;
+    };
 
     // Copy keys to prevent modifying while iterating
-    for (auto &[lhs, _] : G.rules)
-        nonterminals.push_back(lhs);
+    vector<Symbol> nonterminals = nonterminalsByName(G);
 
-    for (auto &lhs : nonterminals)
+    for (Symbol lhs : nonterminals)
     {
-        vector<vector<string>> newRules;
+        Alternatives newRules;
 
-        for (auto rhs : G.rules[lhs])
+        for (size_t k = 0; k < rules[lhs].size(); k++)
         {
-            // If rule has more than 2 symbols (e.g., A → B C D)
-            while (rhs.size() > 2)
-            {
-                // Create a new variable (e.g., Y1)
-                string newVar = "Y" + to_string(++binCount);
-
-                // Next two symbols after the first (C D)
-                vector<string> nextTwo(rhs.begin() + 1, rhs.begin() + 3);
+            rhs.assign(rules[lhs][k].begin(), rules[lhs][k].end());
 
-                // Add rule Y1 → C D
-                G.rules[newVar].push_back(nextTwo);
-
-                // Replace C D with Y1 in the current rule
-                rhs.erase(rhs.begin() + 1, rhs.begin() + 3);
-                rhs.push_back(newVar);
+            // If rule has more than 2 symbols (e.g., A → B C D E), replace
+            // the tail from the right: D E by Y1, then C Y1 by Y2 (A → B Y2)
+            if (rhs.size() > 2)
+            {
+                Symbol tail = rhs.back();
+                for (size_t i = rhs.size() - 2; i >= 1; i--)
+                    tail = pairVar(rhs[i], tail);
+                rhs.resize(1);
+                rhs.push_back(tail);
             }
 
             // Store the shortened binary rule
-            newRules.push_back(rhs);
+            newRules.add(rhs);
         }
 
         // Update grammar for this nonterminal
-        G.rules[lhs] = newRules;
+        rules[lhs] = newRules;
     }
 
+    pack(G, rules);
     printGrammar(G, "Step 4: Binarize (Limit RHS to 2 Symbols)");
 }
 
+// Step 5: Compact the Grammar =====
+// Drop duplicate rules and merge variables that have the same rules once
+// equal variables are identified (e.g., two Y's standing for "A S")
+void compactCNF(Grammar &G)
+{
+    compactGrammar(G);
+    printGrammar(G, "Step 5: Merge Duplicate Rules and Variables");
+}
+
+// Step 0: Remove Useless Symbols =====
+// A variable is useless if it derives no string of terminals, or if the
+// start symbol can't reach it. Their rules are dead weight for every later
+// step, and the ε and unit steps can strand more, so this runs after them
+// too.
+void removeUseless(Grammar &G, const string &title = "")
+{
+    UselessReport removed = removeUselessSymbols(G);
+    if (!title.empty())
+        printGrammar(G, title);
+    printUselessReport(cout, removed);
+}
+
 // ===== Main CNF Conversion Driver =====
 void convertToCNF(Grammar &G)
 {
     printGrammar(G, "Example Grammar:");
+    removeUseless(G, "Step 0: Remove Useless Symbols");
     removeEpsilonProductions(G);
+    removeUseless(G);
     removeUnitProductions(G);
+    removeUseless(G);
     replaceTerminalsInMixedRHS(G);
     binarizeGrammar(G);
+    compactCNF(G);
     cout << "\n✅ CNF Conversion Complete.\n";
 }
 
 int main()
 {
-    Grammar G;
-    G.startSymbol = "S"; // Define the start symbol
-
-    // Example Grammar:
+    // Example Grammar (start symbol S):
     // S → ASB
     // A → aAS | a | ε
     // B → SbS | A | bb
-    G.rules["S"] = {{"A", "S", "B"}};
-    G.rules["A"] = {{"a", "A", "S"}, {"a"}, {"ε"}};
-    G.rules["B"] = {{"S", "b", "S"}, {"A"}, {"b", "b"}};
+    Grammar G = makeGrammar("S", {
+                                     {"S", {{"A", "S", "B"}}},
+                                     {"A", {{"a", "A", "S"}, {"a"}, {"ε"}}},
+                                     {"B", {{"S", "b", "S"}, {"A"}, {"b", "b"}}},
+                                 });
     cout << "\nChomsky Normal Form" << endl;
 
     convertToCNF(G);
@@ -0,0 +1,337 @@
+#pragma once
+// Chomsky normal form: the conversion passes (ε-rules, unit rules, terminals
+// in mixed right-hand sides, binarization) and a bit-parallel CYK recognizer
+// over the converted grammar. The CYK tables can be stored in a precompiled
+// artifact (artifact.h) and used straight from the mapping.
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "artifact.h"
+#include "grammar.h"
+
+// Step 1: Remove ε-productions (rules producing empty string). Nullable
+// nonterminals are found transitively, with a worklist (grammar.h).
+inline void removeEpsilonProductions(Grammar &G) {
+    eliminateEpsilonRules(G);
+}
+
+// Step 2: Remove unit productions (A → B), from the closure of the unit
+// pairs computed in one pass (grammar.h)
+inline void removeUnitProductions(Grammar &G) {
+    eliminateUnitRules(G);
+}
+
+// Step 3: Replace terminals in mixed RHS with new variables
+inline void replaceTerminalsInMixedRHS(Grammar &G) {
+    std::vector<Alternatives> rules = unpack(G);
+    std::vector<Symbol> rhs; // Scratch copy of the rule being rewritten
+    std::map<Symbol, Symbol> terminalMap; // Map terminals to new variables
+    int counter = 0;
+
+    for (Symbol lhs : nonterminalsByName(G)) {
+        Alternatives replaced;
+        for (size_t k = 0; k < rules[lhs].size(); k++) {
+            rhs.assign(rules[lhs][k].begin(), rules[lhs][k].end());
+            for (auto &sym : rhs)
+                if (G.isTerminal(sym) && rhs.size() > 1) {
+                    // Create a new variable for this terminal if it doesn't exist
+                    if (!terminalMap.count(sym)) {
+                        std::string name;
+                        do name = "X" + std::to_string(++counter); while (G.symbols.contains(name));
+                        Symbol newVar = G.symbols.intern(name);
+                        terminalMap[sym] = newVar;
+                        rules.resize(G.symbols.size());
+                        rules[newVar].add({sym}); // Add X → terminal
+                    }
+                    sym = terminalMap[sym]; // Replace terminal with variable
+                }
+            replaced.add(rhs);
+        }
+        rules[lhs] = replaced;
+    }
+    pack(G, rules);
+}
+
+// Step 4: Binarize rules (ensure RHS has ≤ 2 symbols). A → X1 X2 ... Xn
+// becomes A → X1 Y with Y → X2 Y', ..., Y'' → Xn-1 Xn. Each new variable
+// stands for one suffix and is hash-consed on its pair of symbols, so a
+// suffix shared by several rules (S X1 S) gets a single variable.
+inline void binarizeGrammar(Grammar &G) {
+    // Each RHS symbol past the second needs at most one new variable
+    size_t needed = 0;
+    for (size_t p = 0; p < G.productionCount(); p++)
+        needed += std::max<size_t>(G.production(p).size(), 2) - 2;
+    if (needed == 0) return;
+    G.symbols.reserve(G.symbols.size() + needed);
+
+    std::vector<Alternatives> rules = unpack(G);
+    rules.reserve(G.symbols.size() + needed);
+    std::vector<Symbol> rhs; // Scratch copy of the rule being rewritten
+    std::unordered_map<uint64_t, Symbol> suffixes; // (X, Y) -> variable for X Y
+    int binCount = 0;
+    auto suffix = [&](Symbol x, Symbol y) {
+        auto [it, fresh] = suffixes.try_emplace((uint64_t)x << 32 | y, 0);
+        if (fresh) {
+            std::string name;
+            do name = "Y" + std::to_string(++binCount); while (G.symbols.contains(name));
+            it->second = G.symbols.intern(name);
+            rules.resize(G.symbols.size());
+            rules[it->second].add({x, y}); // Add new intermediate rule
+        }
+        return it->second;
+    };
+
+    for (Symbol lhs : nonterminalsByName(G)) {
+        Alternatives newRules;
+        for (size_t k = 0; k < rules[lhs].size(); k++) {
+            rhs.assign(rules[lhs][k].begin(), rules[lhs][k].end());
+            if (rhs.size() > 2) {
+                // Fold the tail from the right: X2 ... Xn becomes one variable
+                Symbol tail = rhs.back();
+                for (size_t i = rhs.size() - 2; i >= 1; i--) tail = suffix(rhs[i], tail);
+                rhs.resize(1);
+                rhs.push_back(tail);
+            }
+            newRules.add(rhs); // Add the final binary rule
+        }
+        rules[lhs] = newRules; // Update rules for this nonterminal
+    }
+    pack(G, rules);
+}
+
+// CNF conversion driver. Useless symbols go first, so no pass works on dead
+// rules, and again after the ε and unit passes, which can strand symbols.
+// Rules are binarized before the ε pass, so each has at most two nullable
+// occurrences and at most four variants, where a long rule with k of them
+// would have 2^k. Compaction at the end merges equivalent variables. What was
+// removed as useless is added to `removed` if given.
+inline void convertToCNF(Grammar &G, UselessReport *removed = nullptr) {
+    UselessReport useless = removeUselessSymbols(G);
+    replaceTerminalsInMixedRHS(G);
+    binarizeGrammar(G);
+    removeEpsilonProductions(G);
+    useless += removeUselessSymbols(G);
+    removeUnitProductions(G);
+    useless += removeUselessSymbols(G);
+    compactGrammar(G);
+    if (removed) *removed += useless;
+}
+
+// ===== CYK membership on a CNF grammar =====
+// Symbol ids index the nonterminal bitsets and binary rules are numbered
+// densely, so every chart cell is a packed bitset. Besides its nonterminals, each cell keeps the binary rules it
+// can serve as left child (B of A → BC) and as right child (C of A → BC), so
+// joining two cells is one word-wide AND over the rule bitsets.
+struct CNFTables {
+    int start = -1;                // Start symbol, -1 if it has no rules
+    bool acceptsEmpty = false;     // S → ε survived the conversion
+    size_t symbols = 0;            // Symbol ids are below this
+    size_t ntWords = 0;            // 64-bit words per nonterminal bitset
+    size_t ruleWords = 0;          // 64-bit words per binary-rule bitset
+    size_t rules = 0;              // Binary rules
+    const Symbol *ruleLhs = nullptr;      // Binary rule r is ruleLhs[r] → B C
+    const uint64_t *asLeft = nullptr;     // [B][ruleWords]: rules whose first RHS symbol is B
+    const uint64_t *asRight = nullptr;    // [C][ruleWords]: rules whose second RHS symbol is C
+    const uint64_t *byTerminal = nullptr; // [byte][ntWords]: nonterminals A with A → byte
+
+    // Storage behind the pointers when compiled in-process (compileCNF);
+    // empty when they point into a mapped artifact (viewCNFTables)
+    std::vector<Symbol> lhsStore;
+    std::vector<uint64_t> store;   // asLeft, asRight, byTerminal back to back
+
+    CNFTables() = default;
+    CNFTables(CNFTables &&) = default; // Moving a vector keeps its buffer, so the pointers stay valid
+    CNFTables &operator=(CNFTables &&) = default;
+    CNFTables(const CNFTables &) = delete;
+};
+
+// Build the CYK tables from the output of convertToCNF
+inline CNFTables compileCNF(const Grammar &G) {
+    CNFTables T;
+    size_t N = G.symbols.size();
+    T.symbols = N;
+    if (G.ruleCount(G.start) == 0) return T; // Start has no rules: empty language
+    T.start = G.start;
+
+    // Number the binary rules A → B C
+    std::vector<std::array<Symbol, 3>> binary;
+    for (Symbol A = 0; A < N; A++)
+        for (uint32_t p = G.firstRule(A); p < G.lastRule(A); p++) {
+            Rhs rhs = G.production(p);
+            if (rhs.size() == 2 && G.isNonTerminal(rhs[0]) && G.isNonTerminal(rhs[1]))
+                binary.push_back({A, rhs[0], rhs[1]});
+        }
+
+    T.ntWords = (N + 63) / 64;
+    T.rules = binary.size();
+    T.ruleWords = (binary.size() + 63) / 64;
+    T.store.assign(2 * N * T.ruleWords + 256 * T.ntWords, 0);
+    uint64_t *asLeft = T.store.data(), *asRight = asLeft + N * T.ruleWords, *byTerminal = asRight + N * T.ruleWords;
+
+    for (size_t r = 0; r < binary.size(); r++) {
+        auto [A, B, C] = binary[r];
+        T.lhsStore.push_back(A);
+        asLeft[B * T.ruleWords + r / 64] |= 1ULL << (r % 64);
+        asRight[C * T.ruleWords + r / 64] |= 1ULL << (r % 64);
+    }
+
+    // Terminal rules A → a, plus S → ε for the empty input
+    for (Symbol A = 0; A < N; A++)
+        for (uint32_t p = G.firstRule(A); p < G.lastRule(A); p++) {
+            Rhs rhs = G.production(p);
+            if (rhs.empty() && A == G.start) T.acceptsEmpty = true;
+            else if (rhs.size() == 1 && G.isTerminal(rhs[0]) && G.name(rhs[0]).size() == 1) {
+                unsigned char c = G.name(rhs[0])[0];
+                byTerminal[c * T.ntWords + A / 64] |= 1ULL << (A % 64);
+            }
+        }
+    T.ruleLhs = T.lhsStore.data();
+    T.asLeft = asLeft, T.asRight = asRight, T.byTerminal = byTerminal;
+    return T;
+}
+
+// Store the CYK tables in an artifact next to the grammar they came from
+inline void addCNFTables(ArtifactWriter &out, const CNFTables &T) {
+    uint64_t header[] = {(uint64_t)(int64_t)T.start, T.acceptsEmpty, T.symbols, T.ntWords, T.ruleWords};
+    out.add(CYKHeader, header, 5);
+    out.add(CYKRuleLhs, T.ruleLhs, T.rules);
+    out.add(CYKAsLeft, T.asLeft, T.asLeft ? T.symbols * T.ruleWords : 0);
+    out.add(CYKAsRight, T.asRight, T.asRight ? T.symbols * T.ruleWords : 0);
+    out.add(CYKByTerminal, T.byTerminal, T.byTerminal ? 256 * T.ntWords : 0);
+}
+
+// Point `T` at the CYK tables stored in `art`; false if they are missing or
+// their sizes disagree
+inline bool viewCNFTables(const Artifact &art, CNFTables &T) {
+    size_t headers, rules, left, right, terminals;
+    const uint64_t *header = art.section<uint64_t>(CYKHeader, headers);
+    T.ruleLhs = art.section<Symbol>(CYKRuleLhs, rules);
+    T.asLeft = art.section<uint64_t>(CYKAsLeft, left);
+    T.asRight = art.section<uint64_t>(CYKAsRight, right);
+    T.byTerminal = art.section<uint64_t>(CYKByTerminal, terminals);
+    if (!header || headers != 5 || !T.ruleLhs || !T.asLeft || !T.asRight || !T.byTerminal) return false;
+    T.start = (int)(int64_t)header[0];
+    T.acceptsEmpty = header[1];
+    T.symbols = header[2], T.ntWords = header[3], T.ruleWords = header[4], T.rules = rules;
+    T.lhsStore.clear(), T.store.clear();
+    if (T.start < 0) return true;
+    return (size_t)T.start < T.symbols && T.ntWords == (T.symbols + 63) / 64 && T.ruleWords == (rules + 63) / 64 &&
+           left == T.symbols * T.ruleWords && right == left && terminals == 256 * T.ntWords;
+}
+
+// Barrier for the CYK workers: the last thread to arrive opens the next phase
+struct SpinBarrier {
+    unsigned count;
+    std::atomic<unsigned> waiting{0}, phase{0};
+    explicit SpinBarrier(unsigned n) : count(n) {}
+    void arriveAndWait() {
+        unsigned p = phase.load(std::memory_order_acquire);
+        if (waiting.fetch_add(1, std::memory_order_acq_rel) + 1 == count) {
+            waiting.store(0, std::memory_order_relaxed);
+            phase.fetch_add(1, std::memory_order_release);
+        } else
+            while (phase.load(std::memory_order_acquire) == p) std::this_thread::yield();
+    }
+};
+
+// CYK recognizer, O(n^3 · |P| / 64). The triangular chart is stored twice:
+// rule bitsets for "rules this cell can start" are laid out by start position
+// and "rules this cell can finish" by end position, so all split points of a
+// span read two contiguous runs of cells.
+//
+// With threads > 1, long inputs are filled as a wavefront: the cells of one
+// span length only read shorter spans, so each anti-diagonal is cut into
+// tiles whose split reads fit in L2, workers claim tiles from a shared
+// counter, and a barrier separates one length from the next.
+inline bool cykRecognize(const CNFTables &T, const std::string &input, unsigned threads = 1) {
+    size_t n = input.size();
+    if (n == 0) return T.acceptsEmpty;
+    if (T.start < 0) return false;
+
+    size_t NW = T.ntWords, RW = T.ruleWords, cells = n * (n + 1) / 2;
+    // Without binary rules only single terminals are derivable, and the
+    // chart would have no rule words to fill
+    if (RW == 0)
+        return n == 1 && (T.byTerminal[(unsigned char)input[0] * NW + T.start / 64] >> (T.start % 64) & 1);
+    auto byStart = [n](size_t i, size_t len) { return i * n - i * (i - 1) / 2 + len - 1; };
+    auto byEnd = [](size_t j, size_t len) { return j * (j + 1) / 2 + len - 1; };
+
+    std::vector<uint64_t> sets(cells * NW, 0);     // Nonterminals per cell, by start
+    std::vector<uint64_t> left(cells * RW, 0);     // Rules the cell can start, by start
+    std::vector<uint64_t> right(cells * RW, 0);    // Rules the cell can finish, by end
+
+    // Derive a cell's rule bitsets from its nonterminal set
+    auto finish = [&](size_t i, size_t len) {
+        const uint64_t *set = &sets[byStart(i, len) * NW];
+        uint64_t *L = &left[byStart(i, len) * RW];
+        uint64_t *R = &right[byEnd(i + len - 1, len) * RW];
+        for (size_t w = 0; w < NW; w++)
+            for (uint64_t bits = set[w]; bits; bits &= bits - 1) {
+                size_t A = w * 64 + __builtin_ctzll(bits);
+                const uint64_t *aL = &T.asLeft[A * RW], *aR = &T.asRight[A * RW];
+                for (size_t k = 0; k < RW; k++) L[k] |= aL[k], R[k] |= aR[k];
+            }
+    };
+
+    // Spans of length 1 come straight from the terminal rules
+    for (size_t i = 0; i < n; i++) {
+        const uint64_t *term = &T.byTerminal[(unsigned char)input[i] * NW];
+        std::copy(term, term + NW, &sets[byStart(i, 1) * NW]);
+        finish(i, 1);
+    }
+
+    // Longer spans: a rule fires if some split has it in both children.
+    // `fired` is caller-owned scratch, one per thread.
+    auto fillCell = [&](size_t i, size_t len, uint64_t *fired) {
+        std::fill(fired, fired + RW, 0);
+        const uint64_t *L = &left[byStart(i, 1) * RW];
+        const uint64_t *R = &right[byEnd(i + len - 1, len - 1) * RW];
+        for (size_t k = 1; k < len; k++, L += RW, R -= RW)
+            for (size_t w = 0; w < RW; w++) fired[w] |= L[w] & R[w];
+
+        uint64_t *set = &sets[byStart(i, len) * NW];
+        for (size_t w = 0; w < RW; w++)
+            for (uint64_t bits = fired[w]; bits; bits &= bits - 1) {
+                Symbol A = T.ruleLhs[w * 64 + __builtin_ctzll(bits)];
+                set[A / 64] |= 1ULL << (A % 64);
+            }
+        finish(i, len);
+    };
+
+    const size_t parallelMin = 256; // Shorter inputs are not worth the barriers
+    threads = (unsigned)std::min<size_t>(threads, n / 2);
+    if (threads <= 1 || n < parallelMin) {
+        std::vector<uint64_t> fired(RW);
+        for (size_t len = 2; len <= n; len++)
+            for (size_t i = 0; i + len <= n; i++) fillCell(i, len, fired.data());
+    } else {
+        const size_t tileBytes = 256 << 10;
+        std::vector<std::atomic<size_t>> nextTile(n + 1); // Per span length, zeroed
+        SpinBarrier barrier(threads);
+        auto worker = [&]() {
+            std::vector<uint64_t> fired(RW);
+            for (size_t len = 2; len <= n; len++) {
+                // A cell reads len - 1 left and right rule bitsets
+                size_t diagonal = n - len + 1;
+                size_t tile = std::max<size_t>(1, tileBytes / ((len - 1) * RW * 2 * sizeof(uint64_t)));
+                size_t tiles = (diagonal + tile - 1) / tile;
+                for (size_t t; (t = nextTile[len].fetch_add(1, std::memory_order_relaxed)) < tiles;)
+                    for (size_t i = t * tile; i < std::min(diagonal, (t + 1) * tile); i++)
+                        fillCell(i, len, fired.data());
+                barrier.arriveAndWait();
+            }
+        };
+        std::vector<std::thread> pool;
+        for (unsigned w = 1; w < threads; w++) pool.emplace_back(worker);
+        worker();
+        for (auto &t : pool) t.join();
+    }
+
+    return (sets[byStart(0, n) * NW + T.start / 64] >> (T.start % 64)) & 1;
+}
@@ -0,0 +1,249 @@
+#pragma once
+// Earley recognizer for the char-keyed grammars used by cfg.cpp and pda-cfg.cpp
+// (unordered_map<char, vector<string>>, a key is a nonterminal, "" is ε).
+// Works on any CFG, including ε-rules and left recursion:
+//   - nullable nonterminals are handled the Aycock–Horspool way: predicting a
+//     nullable B also advances the dot over B, so no ε-completion is needed;
+//   - Leo items memoize deterministic right-recursive completion chains, so
+//     right-recursive grammars are recognized in linear time.
+// Every Earley set lives in one flat item array, indexed by set offsets.
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Grammar compiled into flat arrays. Each dotted rule position ("slot") gets a
+// dense id: rule r owns slots ruleFirstSlot[r] .. ruleFirstSlot[r] + |rhs|.
+struct EarleyGrammar
+{
+    int start = 'S';
+    bool isNonTerminal[256] = {};
+    bool nullable[256] = {};
+    int rulesBegin[257] = {};        // Rules of nonterminal A: rulesBegin[A] .. rulesBegin[A + 1]
+    std::vector<int> ruleLhs;        // Rules are numbered in LHS order
+    std::vector<int> ruleFirstSlot;  // Slot with the dot before the first symbol
+    std::vector<int> slotSymbol;     // Symbol after the dot, or -1 when the dot is at the end
+    std::vector<int> slotRule;       // Rule owning the slot
+};
+
+inline EarleyGrammar compileEarley(const std::unordered_map<char, std::vector<std::string>> &grammar,
+                                   char start = 'S')
+{
+    EarleyGrammar g;
+    g.start = (unsigned char)start;
+    for (auto &[A, _] : grammar)
+        g.isNonTerminal[(unsigned char)A] = true;
+
+    // Number rules grouped by LHS
+    for (int A = 0; A < 256; A++)
+    {
+        g.rulesBegin[A] = (int)g.ruleLhs.size();
+        auto it = grammar.find((char)A);
+        if (it == grammar.end())
+            continue;
+        for (auto &rhs : it->second)
+        {
+            g.ruleLhs.push_back(A);
+            g.ruleFirstSlot.push_back((int)g.slotSymbol.size());
+            for (char c : rhs)
+            {
+                g.slotSymbol.push_back((unsigned char)c);
+                g.slotRule.push_back((int)g.ruleLhs.size() - 1);
+            }
+            g.slotSymbol.push_back(-1);
+            g.slotRule.push_back((int)g.ruleLhs.size() - 1);
+        }
+    }
+    g.rulesBegin[256] = (int)g.ruleLhs.size();
+
+    // Nullable nonterminals: iterate to a fixpoint over the (small) rule set
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (size_t r = 0; r < g.ruleLhs.size(); r++)
+        {
+            if (g.nullable[g.ruleLhs[r]])
+                continue;
+            int s = g.ruleFirstSlot[r];
+            while (g.slotSymbol[s] >= 0 && g.nullable[g.slotSymbol[s]])
+                s++;
+            if (g.slotSymbol[s] < 0)
+                g.nullable[g.ruleLhs[r]] = changed = true;
+        }
+    }
+    return g;
+}
+
+inline bool earleyRecognize(const EarleyGrammar &g, const std::string &input)
+{
+    struct Item
+    {
+        int slot;
+        int origin;
+    };
+    // Items of one finished set that wait on the same symbol; the Leo item for
+    // that symbol is computed on first use and cached here.
+    struct WaitGroup
+    {
+        int symbol;
+        int begin, end;        // Range in `waiting`
+        int leoSlot = -2;      // -2: not computed yet, -1: no Leo item
+        int leoOrigin = 0;
+    };
+
+    size_t n = input.size();
+    std::vector<Item> items;             // All sets, back to back
+    std::vector<size_t> setBegin{0};     // Set i is items[setBegin[i] .. setBegin[i + 1])
+    std::vector<int> waiting;            // Item indices grouped by postdot symbol, per set
+    std::vector<WaitGroup> groups;       // Groups of set i: groupBegin[i] .. groupBegin[i + 1]
+    std::vector<size_t> groupBegin{0};
+
+    // Open-addressing dedup table for the set being built; a generation stamp
+    // clears it in O(1) when the next set starts
+    std::vector<uint64_t> keys(64);
+    std::vector<uint32_t> stamp(64, 0);
+    uint32_t generation = 1;
+    size_t used = 0;
+
+    auto slotOf = [&](uint64_t key) {
+        size_t mask = keys.size() - 1, h = (key * 0x9E3779B97F4A7C15ULL) >> 20;
+        while (stamp[h & mask] == generation && keys[h & mask] != key)
+            h++;
+        return h & mask;
+    };
+    auto add = [&](int slot, int origin) {
+        uint64_t key = (uint64_t)slot << 32 | (uint32_t)origin;
+        size_t h = slotOf(key);
+        if (stamp[h] == generation)
+            return;
+        keys[h] = key, stamp[h] = generation;
+        items.push_back({slot, origin});
+        if (++used * 2 > keys.size())
+        {
+            // Grow and re-insert the items of the current set
+            keys.assign(keys.size() * 2, 0);
+            stamp.assign(stamp.size() * 2, 0);
+            for (size_t k = setBegin.back(); k < items.size(); k++)
+            {
+                uint64_t kk = (uint64_t)items[k].slot << 32 | (uint32_t)items[k].origin;
+                size_t hh = slotOf(kk);
+                keys[hh] = kk, stamp[hh] = generation;
+            }
+        }
+    };
+    auto newSet = [&]() {
+        setBegin.push_back(items.size());
+        generation++, used = 0;
+    };
+    auto findGroup = [&](size_t set, int symbol) -> WaitGroup * {
+        auto first = groups.begin() + groupBegin[set], last = groups.begin() + groupBegin[set + 1];
+        auto it = std::lower_bound(first, last, symbol,
+                                   [](const WaitGroup &w, int s) { return w.symbol < s; });
+        return (it != last && it->symbol == symbol) ? &*it : nullptr;
+    };
+
+    // Leo item for (set j, symbol A): if the only item of set j waiting on A is
+    // B → β•A with origin k < j, completing A in a later set also completes B
+    // there; follow that chain down and remember its topmost item. Origins
+    // strictly decrease along the chain, so it always terminates.
+    std::vector<WaitGroup *> chain;
+    auto leoTop = [&](size_t j, WaitGroup *group) {
+        chain.clear();
+        int topSlot = -1, topOrigin = 0;
+        while (group && group->leoSlot == -2)
+        {
+            const Item &w = items[waiting[group->begin]];
+            if (group->end - group->begin != 1 || g.slotSymbol[w.slot + 1] >= 0 || (size_t)w.origin >= j)
+            {
+                group->leoSlot = -1;
+                break;
+            }
+            chain.push_back(group);
+            j = w.origin;
+            group = findGroup(j, g.ruleLhs[g.slotRule[w.slot]]);
+        }
+        if (group && group->leoSlot >= 0)
+            topSlot = group->leoSlot, topOrigin = group->leoOrigin;
+        // Unwind: each group's Leo item is the deeper one, or its own completion
+        for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+        {
+            if (topSlot < 0)
+            {
+                const Item &w = items[waiting[(*it)->begin]];
+                topSlot = w.slot + 1, topOrigin = w.origin;
+            }
+            (*it)->leoSlot = topSlot, (*it)->leoOrigin = topOrigin;
+        }
+    };
+
+    for (int r = g.rulesBegin[g.start]; r < g.rulesBegin[g.start + 1]; r++)
+        add(g.ruleFirstSlot[r], 0);
+
+    std::vector<std::pair<int, int>> sorter; // (postdot symbol, item index)
+    for (size_t i = 0; i <= n; i++)
+    {
+        // Predict and complete until set i stops growing
+        for (size_t p = setBegin[i]; p < items.size(); p++)
+        {
+            Item it = items[p];
+            int sym = g.slotSymbol[it.slot];
+            if (sym < 0)
+            {
+                // Completions inside set i are covered by the nullable rule below
+                if ((size_t)it.origin == i)
+                    continue;
+                WaitGroup *group = findGroup(it.origin, g.ruleLhs[g.slotRule[it.slot]]);
+                if (!group)
+                    continue;
+                leoTop(it.origin, group);
+                if (group->leoSlot >= 0)
+                    add(group->leoSlot, group->leoOrigin);
+                else
+                    for (int w = group->begin; w < group->end; w++)
+                        add(items[waiting[w]].slot + 1, items[waiting[w]].origin);
+            }
+            else if (g.isNonTerminal[sym])
+            {
+                for (int r = g.rulesBegin[sym]; r < g.rulesBegin[sym + 1]; r++)
+                    add(g.ruleFirstSlot[r], (int)i);
+                if (g.nullable[sym])
+                    add(it.slot + 1, it.origin);
+            }
+        }
+
+        // Index set i by postdot symbol for later completions and the scan
+        sorter.clear();
+        for (size_t p = setBegin[i]; p < items.size(); p++)
+            if (g.slotSymbol[items[p].slot] >= 0)
+                sorter.push_back({g.slotSymbol[items[p].slot], (int)p});
+        std::sort(sorter.begin(), sorter.end());
+        for (size_t k = 0; k < sorter.size(); k++)
+        {
+            if (k == 0 || sorter[k].first != sorter[k - 1].first)
+                groups.push_back({sorter[k].first, (int)waiting.size(), (int)waiting.size()});
+            waiting.push_back(sorter[k].second);
+            groups.back().end++;
+        }
+        groupBegin.push_back(groups.size());
+
+        if (i == n)
+            break;
+
+        // Scan input[i] into set i + 1
+        newSet();
+        int c = (unsigned char)input[i];
+        if (WaitGroup *group = g.isNonTerminal[c] ? nullptr : findGroup(i, c))
+            for (int w = group->begin; w < group->end; w++)
+                add(items[waiting[w]].slot + 1, items[waiting[w]].origin);
+        if (setBegin.back() == items.size())
+            return false; // Nothing can continue past input[i]
+    }
+
+    for (size_t p = setBegin[n]; p < items.size(); p++)
+        if (items[p].origin == 0 && g.slotSymbol[items[p].slot] < 0 &&
+            g.ruleLhs[g.slotRule[items[p].slot]] == g.start)
+            return true;
+    return false;
+}
@@ -0,0 +1,129 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include "batch.h"
+#include "generate.h"
+using namespace std;
+
+// Workload generator (see generate.h). Everything is determined by --seed
+// (default 1), so a workload can be regenerated instead of stored.
+//   gen grammar [--variables N] [--productions P] [--terminals T] [--min-rhs K]
+//               [--max-rhs K] [--epsilon X] [--nonterminals X]
+//               [--left-recursion X] [--ambiguity X]
+//       a random grammar in printRules format (gnf2 --grammar, cfgc)
+//   gen lba [--states N] [--symbols K] [--tape-symbols K] [--density X] [--stay X]
+//       a random LBA in printLBA format (lba2 --machine)
+//   gen inputs --grammar FILE --length N [--count K] [--negative]
+//       strings of the grammar's language, or near misses outside it
+//   gen inputs --machine FILE --length N [--count K] [--negative] [--alphabet ab]
+//       random words the machine accepts, or rejects
+// Inputs come one per line, ready for the simulators' --batch mode.
+
+double flagReal(int argc, char *argv[], const char *flag, double fallback)
+{
+    string text = flagText(argc, argv, flag);
+    return text.empty() ? fallback : stod(text);
+}
+
+int grammar(int argc, char *argv[], uint64_t seed)
+{
+    GrammarShape shape;
+    shape.variables = flagValue(argc, argv, "--variables", shape.variables);
+    shape.productions = flagValue(argc, argv, "--productions", 3 * shape.variables);
+    shape.terminals = flagValue(argc, argv, "--terminals", shape.terminals);
+    shape.minRhs = flagValue(argc, argv, "--min-rhs", shape.minRhs);
+    shape.maxRhs = flagValue(argc, argv, "--max-rhs", shape.maxRhs);
+    shape.epsilon = flagReal(argc, argv, "--epsilon", shape.epsilon);
+    shape.nonterminals = flagReal(argc, argv, "--nonterminals", shape.nonterminals);
+    shape.leftRecursion = flagReal(argc, argv, "--left-recursion", shape.leftRecursion);
+    shape.ambiguity = flagReal(argc, argv, "--ambiguity", shape.ambiguity);
+    Grammar G = randomGrammar(shape, seed);
+    cout << "# gen grammar --seed " << seed << ": " << G.symbolCount() << " symbols, " << G.productionCount()
+         << " productions\n";
+    printRules(G);
+    return 0;
+}
+
+int lba(int argc, char *argv[], uint64_t seed)
+{
+    LBAShape shape;
+    shape.states = flagValue(argc, argv, "--states", shape.states);
+    shape.inputSymbols = flagValue(argc, argv, "--symbols", shape.inputSymbols);
+    shape.tapeSymbols = flagValue(argc, argv, "--tape-symbols", shape.tapeSymbols);
+    shape.density = flagReal(argc, argv, "--density", shape.density);
+    shape.stay = flagReal(argc, argv, "--stay", shape.stay);
+    LBATransitions transitions = randomLBA(shape, seed);
+    cout << "# gen lba --seed " << seed << "\n";
+    printLBA(cout, transitions, "q0", "q" + to_string(max<size_t>(shape.states, 2) - 1));
+    return 0;
+}
+
+int inputs(int argc, char *argv[], uint64_t seed)
+{
+    size_t length = flagValue(argc, argv, "--length", 16), count = flagValue(argc, argv, "--count", 1);
+    bool negative = hasFlag(argc, argv, "--negative");
+    string grammarPath = flagText(argc, argv, "--grammar"), machinePath = flagText(argc, argv, "--machine"), error;
+    string path = grammarPath.empty() ? machinePath : grammarPath;
+    ifstream file(path);
+    if (path.empty() || !file)
+    {
+        cerr << (path.empty() ? "gen inputs needs --grammar FILE or --machine FILE" : "Cannot open " + path) << endl;
+        return 1;
+    }
+
+    SplitMix rng{seed};
+    size_t made = 0;
+    if (!grammarPath.empty())
+    {
+        Grammar G;
+        if (!readGrammar(file, G, error))
+        {
+            cerr << path << ": " << error << endl;
+            return 1;
+        }
+        GrammarSampler sampler(G);
+        string positive, miss;
+        for (size_t k = 0; k < count && sampler.sample(length, rng, positive); k++)
+            if (!negative)
+                cout << positive << "\n", made++;
+            else if (sampler.nearMiss(positive, rng, miss))
+                cout << miss << "\n", made++;
+    }
+    else
+    {
+        LBATransitions transitions;
+        string start, accept;
+        if (!readLBA(file, transitions, start, accept, error))
+        {
+            cerr << path << ": " << error << endl;
+            return 1;
+        }
+        // Rejection sampling: random words until enough have the wanted verdict
+        LBATable table = compileLBA(transitions, start, accept);
+        string alphabet = flagText(argc, argv, "--alphabet", "ab");
+        size_t maxSteps = flagValue(argc, argv, "--max-steps", 0);
+        for (size_t tries = 0; made < count && tries < 1000 * count; tries++)
+        {
+            string word = randomWord(alphabet, length, rng);
+            if ((simulateLBA(table, word, maxSteps) == Accepts) != negative)
+                cout << word << "\n", made++;
+        }
+    }
+    if (made < count)
+        cerr << "Only " << made << " of " << count << " inputs found" << endl;
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    string mode = argc > 1 ? argv[1] : "";
+    uint64_t seed = flagValue(argc, argv, "--seed", 1);
+    if (mode == "grammar")
+        return grammar(argc, argv, seed);
+    if (mode == "lba")
+        return lba(argc, argv, seed);
+    if (mode == "inputs")
+        return inputs(argc, argv, seed);
+    cerr << "Usage: gen grammar|lba|inputs [options] [--seed S]   (see gen.cpp)\n";
+    return 1;
+}
@@ -0,0 +1,340 @@
+#pragma once
+// Seeded workload generators for stress and scaling tests: random grammars of
+// a chosen shape, random LBA transition tables, and inputs of a chosen length
+// that are in a grammar's language (sampled from it) or just outside it
+// (near-miss mutations of a sample). The same seed always gives the same
+// output. Grammars come out as a Grammar (printRules/readGrammar format on
+// disk) and machines as LBATransitions (printLBA/readLBA format).
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "cnf.h"
+#include "grammar.h"
+#include "lba.h"
+
+// SplitMix64 stream: small, fast and fully determined by its seed
+struct SplitMix
+{
+    uint64_t state;
+    uint64_t next() { return mix64(state += 0x9E3779B97F4A7C15ULL); }
+    size_t below(size_t n) { return n ? next() % n : 0; }
+    bool chance(double p) { return (next() >> 11) * 0x1.0p-53 < p; }
+};
+
+struct GrammarShape
+{
+    size_t variables = 8;          // |N|: S, N1, N2, ...
+    size_t productions = 24;       // |P|, at least two per variable but the last
+    size_t terminals = 4;          // Terminals a, b, ... (at most 26)
+    size_t minRhs = 1, maxRhs = 4; // Length of a non-ε right-hand side
+    double epsilon = 0.05;         // Chance that a production is ε
+    double nonterminals = 0.4;     // Chance that a right-hand side symbol is a variable
+    double leftRecursion = 0;      // Chance that a variable starts a left-recursive cycle
+    double ambiguity = 0;          // Chance that a variable gets a second derivation of one rule
+};
+
+// Random grammar of the given shape. Every variable has one terminal-only
+// production, so all of them generate strings, and variable i has a
+// production calling variable i + 1, so all of them are reachable; the other
+// productions are random.
+//   - left recursion: variable i's first production is made to start with
+//     variable i (direct), or with i + 1 whose first production starts with i
+//     (a cycle of two), or so on up to three;
+//   - ambiguity: for a production A → X β, some other variable B gets B → X
+//     and A gets A → B β, so every string through that production has two
+//     derivations. These two productions are part of |P|.
+inline Grammar randomGrammar(GrammarShape shape, uint64_t seed)
+{
+    SplitMix rng{seed};
+    size_t N = std::max<size_t>(shape.variables, 1);
+    shape.terminals = std::min<size_t>(std::max<size_t>(shape.terminals, 1), 26);
+    shape.maxRhs = std::max(shape.maxRhs, std::max<size_t>(shape.minRhs, 1));
+    shape.minRhs = std::max<size_t>(shape.minRhs, 1);
+    auto var = [](size_t i) { return i ? "N" + std::to_string(i) : std::string("S"); };
+    auto terminal = [&]() { return std::string(1, 'a' + rng.below(shape.terminals)); };
+    auto length = [&]() { return shape.minRhs + rng.below(shape.maxRhs - shape.minRhs + 1); };
+
+    std::vector<bool> ambiguous(N);
+    size_t extra = 0;
+    for (size_t i = 0; i < N; i++)
+        if ((ambiguous[i] = N > 1 && rng.chance(shape.ambiguity)))
+            extra += 2;
+
+    // Production counts: one terminal-only and (but the last) one calling the
+    // next variable each, the rest spread at random
+    std::vector<size_t> count(N, 2);
+    count[N - 1] = 1;
+    size_t fixed = 2 * N - 1 + extra;
+    for (size_t k = fixed; k < shape.productions; k++)
+        count[rng.below(N)]++;
+
+    std::vector<std::vector<std::vector<std::string>>> rules(N);
+    for (size_t i = 0; i < N; i++)
+    {
+        for (size_t k = 1; k < count[i]; k++)
+        {
+            std::vector<std::string> rhs;
+            if (!rng.chance(shape.epsilon) || k == 1)
+                for (size_t len = length(); len > 0; len--)
+                    rhs.push_back(rng.chance(shape.nonterminals) ? var(rng.below(N)) : terminal());
+            if (k == 1 && i + 1 < N)
+                rhs.insert(rhs.begin() + rng.below(rhs.size() + 1), var(i + 1));
+            rules[i].push_back(rhs);
+        }
+        std::vector<std::string> exit;
+        for (size_t len = length(); len > 0; len--)
+            exit.push_back(terminal());
+        rules[i].push_back(exit);
+    }
+
+    // Left-recursive cycles i → i+1 → ... → i through first symbols
+    for (size_t i = 0; i < N; i++)
+        if (rules[i].size() > 1 && rng.chance(shape.leftRecursion))
+        {
+            // Only variables with a production besides the terminal-only one
+            size_t cycle = 1 + rng.below(3);
+            while (cycle > 1 && (i + cycle > N || rules[i + cycle - 1].size() < 2))
+                cycle--;
+            for (size_t k = 0; k < cycle; k++)
+            {
+                auto &first = rules[i + k].front();
+                first.insert(first.begin(), var(k + 1 < cycle ? i + k + 1 : i));
+            }
+        }
+
+    // Second derivations: A → X β gains A → B β with B → X
+    for (size_t i = 0; i < N; i++)
+        if (ambiguous[i])
+        {
+            std::vector<std::string> rhs = rules[i][rng.below(rules[i].size())];
+            if (rhs.empty())
+                rhs.push_back(terminal());
+            size_t b = rng.below(N - 1);
+            b += b >= i;
+            rules[b].push_back({rhs.front()});
+            rhs.front() = var(b);
+            rules[i].push_back(rhs);
+        }
+
+    std::vector<std::pair<std::string, std::vector<std::vector<std::string>>>> named;
+    for (size_t i = 0; i < N; i++)
+    {
+        for (auto &rhs : rules[i])
+            if (rhs.empty())
+                rhs.push_back("ε");
+        named.push_back({var(i), rules[i]});
+    }
+    return makeGrammar("S", named);
+}
+
+// Samples strings of a grammar whose terminals are single characters, and
+// decides membership for near-miss candidates with CYK on a CNF copy. The
+// grammar must outlive the sampler.
+class GrammarSampler
+{
+  public:
+    explicit GrammarSampler(const Grammar &G) : G(G)
+    {
+        size_t N = G.symbols.size();
+        const size_t infinite = SIZE_MAX / 4;
+        minYield.assign(N, infinite);
+        for (Symbol s = 0; s < N; s++)
+            if (G.isTerminal(s))
+            {
+                minYield[s] = 1;
+                alphabet += G.name(s)[0];
+            }
+
+        // Minimum yield of each variable, by relaxing every rule until
+        // nothing improves
+        for (bool changed = true; changed;)
+        {
+            changed = false;
+            for (Symbol A = 0; A < N; A++)
+                for (uint32_t p = G.firstRule(A); p < G.lastRule(A); p++)
+                    if (size_t y = yield(p); y < minYield[A])
+                        minYield[A] = y, changed = true;
+        }
+
+        // Shortest way out of each variable: a production of minimum yield
+        // whose variables all have their way out already. Following these
+        // always terminates, even through unit and ε cycles.
+        shortest.assign(N, UINT32_MAX);
+        for (bool changed = true; changed;)
+        {
+            changed = false;
+            for (Symbol A = 0; A < N; A++)
+                for (uint32_t p = G.firstRule(A); p < G.lastRule(A) && shortest[A] == UINT32_MAX; p++)
+                {
+                    Rhs rhs = G.production(p);
+                    bool ready = yield(p) == minYield[A] &&
+                                 std::all_of(rhs.begin(), rhs.end(), [&](Symbol s) {
+                                     return G.isTerminal(s) || shortest[s] != UINT32_MAX;
+                                 });
+                    if (ready)
+                        shortest[A] = p, changed = true;
+                }
+        }
+
+        Grammar cnf = G;
+        convertToCNF(cnf);
+        tables = compileCNF(cnf);
+    }
+
+    // True if the language has at least one string
+    bool nonEmpty() const { return shortest[G.start] != UINT32_MAX; }
+
+    bool accepts(const std::string &input) const { return cykRecognize(tables, input); }
+
+    // A random string of the language, of length at most n and as close to n
+    // as the leftmost expansion can get (or the shortest string, if even that
+    // is longer): while there is room, each variable takes a random
+    // production that still fits and calls a variable, then the rest take
+    // their shortest way out. False if the language is empty.
+    bool sample(size_t n, SplitMix &rng, std::string &out) const
+    {
+        out.clear();
+        if (!nonEmpty())
+            return false;
+        std::vector<Symbol> stack = {G.start}; // Top at the back
+        size_t pending = minYield[G.start];    // Minimum yield of the stack
+        size_t steps = 0, budget = 16 * n + 1024;
+        std::vector<uint32_t> growing, fitting;
+        while (!stack.empty())
+        {
+            Symbol X = stack.back();
+            stack.pop_back();
+            pending -= minYield[X];
+            if (G.isTerminal(X))
+            {
+                out += G.name(X);
+                continue;
+            }
+            size_t now = out.size() + pending; // Length already committed to elsewhere
+            uint32_t chosen = shortest[X];
+            if (++steps <= budget && now + minYield[X] < n)
+            {
+                growing.clear(), fitting.clear();
+                for (uint32_t p = G.firstRule(X); p < G.lastRule(X); p++)
+                {
+                    Rhs rhs = G.production(p);
+                    size_t y = yield(p);
+                    if (y >= SIZE_MAX / 4 || now + y > n)
+                        continue;
+                    fitting.push_back(p);
+                    if (std::any_of(rhs.begin(), rhs.end(), [&](Symbol s) { return G.isNonTerminal(s); }))
+                        growing.push_back(p);
+                }
+                const auto &pick = growing.empty() ? fitting : growing;
+                if (!pick.empty())
+                    chosen = pick[rng.below(pick.size())];
+            }
+            Rhs rhs = G.production(chosen);
+            for (size_t k = rhs.size(); k-- > 0;)
+            {
+                stack.push_back(rhs[k]);
+                pending += minYield[rhs[k]];
+            }
+        }
+        return true;
+    }
+
+    // A string outside the language one edit away from `positive`: a symbol
+    // replaced, inserted or deleted, or two neighbours swapped. Candidates
+    // are checked with CYK (cubic in their length); false if `attempts`
+    // random edits all stayed inside the language.
+    bool nearMiss(const std::string &positive, SplitMix &rng, std::string &out, int attempts = 64) const
+    {
+        if (alphabet.empty())
+            return false;
+        for (int a = 0; a < attempts; a++)
+        {
+            out = positive;
+            size_t at = rng.below(out.size() + 1);
+            char c = alphabet[rng.below(alphabet.size())];
+            switch (out.empty() ? 1 : rng.below(4))
+            {
+            case 0:
+                out[std::min(at, out.size() - 1)] = c;
+                break;
+            case 1:
+                out.insert(out.begin() + at, c);
+                break;
+            case 2:
+                out.erase(std::min(at, out.size() - 1), 1);
+                break;
+            default:
+                if (out.size() > 1)
+                {
+                    at = std::min(at, out.size() - 2);
+                    std::swap(out[at], out[at + 1]);
+                }
+            }
+            if (out != positive && !accepts(out))
+                return true;
+        }
+        return false;
+    }
+
+  private:
+    const Grammar &G;
+    std::vector<size_t> minYield;  // Per symbol; SIZE_MAX / 4 if it derives nothing
+    std::vector<uint32_t> shortest; // Per variable: production of its shortest way out
+    std::string alphabet;           // The terminals
+    CNFTables tables;
+
+    size_t yield(uint32_t p) const
+    {
+        size_t total = 0;
+        for (Symbol s : G.production(p))
+            total = std::min(total + minYield[s], SIZE_MAX / 4);
+        return total;
+    }
+};
+
+struct LBAShape
+{
+    size_t states = 4;       // q0 (start) .. q<states - 1> (accept)
+    size_t inputSymbols = 2; // Input alphabet a, b, ...
+    size_t tapeSymbols = 2;  // Extra symbols Z, Y, ... the machine may write
+    double density = 0.7;    // Chance that a (state, symbol) pair has a transition
+    double stay = 0.1;       // Chance that a transition leaves the head in place
+};
+
+// Random deterministic LBA: states q0 .. q<n-1>, start q0, accept q<n-1>
+// (which has no transitions). Each non-accepting state reads every input
+// and tape symbol with probability `density`.
+inline LBATransitions randomLBA(LBAShape shape, uint64_t seed)
+{
+    SplitMix rng{seed};
+    size_t states = std::max<size_t>(shape.states, 2);
+    shape.inputSymbols = std::min<size_t>(std::max<size_t>(shape.inputSymbols, 1), 26);
+    shape.tapeSymbols = std::min<size_t>(shape.tapeSymbols, 26);
+    std::string symbols;
+    for (size_t k = 0; k < shape.inputSymbols; k++)
+        symbols += (char)('a' + k);
+    for (size_t k = 0; k < shape.tapeSymbols; k++)
+        symbols += (char)('Z' - k);
+
+    LBATransitions T;
+    for (size_t q = 0; q + 1 < states; q++)
+        for (char c : symbols)
+            if (rng.chance(shape.density))
+            {
+                char move = rng.chance(shape.stay) ? 'S' : rng.below(2) ? 'R' : 'L';
+                T[{"q" + std::to_string(q), c}] = {"q" + std::to_string(rng.below(states)),
+                                                   symbols[rng.below(symbols.size())], move};
+            }
+    return T;
+}
+
+// Random word of `length` symbols drawn from `alphabet`
+inline std::string randomWord(const std::string &alphabet, size_t length, SplitMix &rng)
+{
+    std::string word(length, ' ');
+    for (char &c : word)
+        c = alphabet[rng.below(alphabet.size())];
+    return word;
+}
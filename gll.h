@@ -0,0 +1,278 @@
+#pragma once
+// GLL recognizer for the PDA of a char-keyed CFG (cfg-pda.cpp): the PDA's
+// stacks are kept in one graph-structured stack, so every nondeterministic
+// choice is explored without copying stacks, and left recursion and ε-rules
+// terminate.
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "stats.h"
+
+// Grammar flattened into dotted positions ("slots"): rule r owns slots
+// first[r] .. first[r] + |rhs|, and symbol[slot] is the symbol after the dot
+// (-1 once the dot reaches the end of the rule)
+struct Slots
+{
+    std::vector<char> lhs;                            // Per rule
+    std::vector<int> first;                           // Per rule
+    std::vector<int> symbol;                          // Per slot
+    std::unordered_map<char, std::vector<int>> rules; // Nonterminal -> its rule ids
+};
+
+// Node of the graph-structured stack: "after the nonterminal called at input
+// position `pos` has been matched, continue at grammar slot `slot`". Stacks
+// that share a suffix share these nodes instead of copying it.
+struct GSSNode
+{
+    int slot;
+    int pos;
+    std::vector<int> edges; // GSS nodes below this one
+    std::vector<int> pops;  // Input positions at which the call has already returned
+};
+
+// GLL work item: continue at `slot` with stack `node` from input position `pos`
+struct Descriptor
+{
+    int slot, node, pos;
+    bool operator==(const Descriptor &o) const { return slot == o.slot && node == o.node && pos == o.pos; }
+};
+
+struct DescriptorHash
+{
+    size_t operator()(const Descriptor &d) const
+    {
+        return (((size_t)d.slot * 0x9E3779B97F4A7C15ULL) ^ ((size_t)d.node << 21) ^ d.pos) * 0xBF58476D1CE4E5B9ULL;
+    }
+};
+
+// Key for "nonterminal X was matched starting at input position i"
+inline uint64_t callKey(char X, int i) { return (uint64_t)(unsigned char)X << 32 | (uint32_t)i; }
+
+// Rebuild one derivation of X over input[i..j) from the recorded returns, as the
+// list of applied rules in leftmost order. Only returns recorded before
+// `before` are used, so every sub-derivation is itself rebuildable and the
+// recursion cannot cycle.
+inline bool explain(const Slots &G, const std::unordered_map<uint64_t, std::vector<std::pair<int, int>>> &returns,
+                    const std::string &input, char X, int i, int j, int before, std::vector<int> &applied)
+{
+    struct Reach
+    {
+        int pos;  // Input position after k symbols of the rule
+        int prev; // Entry in the previous layer
+        int time; // Recording time of the nonterminal matched on this step
+    };
+    auto found = G.rules.find(X);
+    if (found == G.rules.end())
+        return false;
+
+    for (int r : found->second)
+    {
+        // layers[k] = input positions reachable after the first k rule symbols
+        std::vector<std::vector<Reach>> layers(1, {{i, -1, -1}});
+        for (int slot = G.first[r]; G.symbol[slot] >= 0; slot++)
+        {
+            char sym = G.symbol[slot];
+            std::vector<Reach> next;
+            std::unordered_set<int> seen;
+            auto push = [&](Reach e) {
+                if (e.pos <= j && seen.insert(e.pos).second)
+                    next.push_back(e);
+            };
+            for (int e = 0; e < (int)layers.back().size(); e++)
+            {
+                int pos = layers.back()[e].pos;
+                if (!G.rules.count(sym))
+                {
+                    if (pos < j && input[pos] == sym)
+                        push({pos + 1, e, -1});
+                }
+                else if (auto it = returns.find(callKey(sym, pos)); it != returns.end())
+                    for (auto [end, time] : it->second)
+                        if (time < before)
+                            push({end, e, time});
+            }
+            layers.push_back(next);
+        }
+
+        // Walk back from position j to recover the split points
+        int e = -1;
+        for (int k = 0; k < (int)layers.back().size(); k++)
+            if (layers.back()[k].pos == j)
+                e = k;
+        if (e < 0)
+            continue;
+        std::vector<Reach> path;
+        for (int k = (int)layers.size() - 1; k > 0; k--)
+            path.push_back(layers[k][e]), e = layers[k][e].prev;
+        std::reverse(path.begin(), path.end());
+
+        applied.push_back(r);
+        int pos = i;
+        for (size_t k = 0; k < path.size(); k++)
+        {
+            char sym = G.symbol[G.first[r] + k];
+            if (G.rules.count(sym))
+                explain(G, returns, input, sym, pos, path[k].pos, path[k].time, applied);
+            pos = path[k].pos;
+        }
+        return true;
+    }
+    return false;
+}
+
+// Flatten the grammar into slots
+inline Slots compileSlots(const std::unordered_map<char, std::vector<std::string>> &grammar)
+{
+    Slots G;
+    for (auto &[A, prods] : grammar)
+        for (auto &prod : prods)
+        {
+            G.rules[A].push_back(G.lhs.size());
+            G.first.push_back(G.symbol.size());
+            G.symbol.insert(G.symbol.end(), prod.begin(), prod.end());
+            G.symbol.push_back(-1);
+            G.lhs.push_back(A);
+        }
+    return G;
+}
+
+// Simulate the PDA of a CFG with a GLL search. Each distinct descriptor
+// (slot, GSS node, input position) is processed once, which bounds the search
+// by O(n^3) and lets it terminate on left recursion and ε-rules. Accepts when
+// the stack is empty and the input fully read, as the PDA does. With
+// trace = false no transitions are rebuilt and nothing is printed.
+inline bool simulateCFGtoPDA(const std::string &input, const Slots &G, bool trace = true)
+{
+    QueryStats stats("simulateCFGtoPDA", input.size());
+    int n = input.size();
+    std::vector<GSSNode> gss = {{-1, 0, {}, {}}}; // Node 0: the empty stack below S
+    std::unordered_map<uint64_t, int> gssIndex;
+    std::unordered_set<uint64_t> edgeSeen, popSeen;
+    std::unordered_set<Descriptor, DescriptorHash> seen;
+    std::vector<Descriptor> work;
+    std::unordered_map<uint64_t, std::vector<std::pair<int, int>>> returns; // (X, i) -> (j, recording time)
+    int clock = 0;
+    bool accepted = false;
+
+    auto add = [&](int slot, int node, int pos) {
+        stats.add(Generated);
+        if (!seen.insert({slot, node, pos}).second)
+            return stats.add(Duplicates);
+        work.push_back({slot, node, pos});
+        stats.peak(FrontierPeak, work.size());
+        stats.peak(FrontierBytes, work.size() * sizeof(Descriptor));
+    };
+
+    // The nonterminal called at GSS node `node` has been matched up to `pos`
+    auto pop = [&](int node, int pos) {
+        if (node == 0)
+        {
+            returns[callKey('S', 0)].push_back({pos, clock++});
+            accepted |= pos == n; // Stack empty: accept if the input is used up
+            return;
+        }
+        if (!popSeen.insert((uint64_t)node << 32 | pos).second)
+            return;
+        GSSNode &v = gss[node];
+        stats.add(Pops);
+        stats.sample(PopFanout, v.edges.size());
+        returns[callKey(G.symbol[v.slot - 1], v.pos)].push_back({pos, clock++});
+        v.pops.push_back(pos);
+        for (int below : v.edges)
+            add(v.slot, below, pos);
+    };
+
+    // Push: call the nonterminal after `slot` on top of stack `node`
+    auto call = [&](int slot, int node, int pos) {
+        auto [it, fresh] = gssIndex.try_emplace((uint64_t)(slot + 1) << 32 | pos, gss.size());
+        if (fresh)
+            gss.push_back({slot + 1, pos, {}, {}}), stats.add(GSSNodes);
+        int v = it->second;
+        if (edgeSeen.insert((uint64_t)v << 32 | node).second)
+        {
+            gss[v].edges.push_back(node);
+            stats.add(GSSEdges);
+            // Returns that happened before this edge existed
+            for (int j : gss[v].pops)
+                add(slot + 1, node, j);
+        }
+        for (int r : G.rules.at(G.symbol[slot]))
+            add(G.first[r], v, pos);
+    };
+
+    // Start with stack = S (start symbol)
+    if (auto start = G.rules.find('S'); start != G.rules.end())
+        for (int r : start->second)
+            add(G.first[r], 0, 0);
+    stats.phase(Search);
+
+    while (!work.empty() && !accepted)
+    {
+        auto [slot, node, pos] = work.back();
+        work.pop_back();
+        stats.add(Expanded);
+
+        // Match terminals in place; stop at the first nonterminal or the rule end
+        while (G.symbol[slot] >= 0 && !G.rules.count(G.symbol[slot]))
+        {
+            if (pos >= n || input[pos] != G.symbol[slot])
+                break;
+            slot++, pos++;
+        }
+        if (G.symbol[slot] < 0)
+            pop(node, pos);
+        else if (G.rules.count(G.symbol[slot]))
+            call(slot, node, pos);
+    }
+
+    // Memory held by the search: the GSS with its edge and return lists, and
+    // the sets of descriptors, edges and returns already seen
+    if constexpr (engineStats)
+    {
+        size_t bytes = gss.size() * sizeof(GSSNode) + seen.size() * sizeof(Descriptor) +
+                       (edgeSeen.size() + popSeen.size()) * sizeof(uint64_t);
+        for (const GSSNode &v : gss)
+            bytes += (v.edges.size() + v.pops.size()) * sizeof(int);
+        stats.peak(ArenaBytes, bytes);
+    }
+
+    if (!accepted)
+    {
+        if (trace)
+            std::cout << "\nString rejected!\n";
+        return stats.result(false);
+    }
+    if (!trace)
+        return stats.result(true);
+
+    // Replay one accepting run to print the PDA transitions
+    stats.phase(Replay);
+    std::vector<int> applied;
+    explain(G, returns, input, 'S', 0, n, clock, applied);
+    std::string stackContent = "S", path = "[S]"; // Stack as string (top at back)
+    size_t next = 0;
+    while (!stackContent.empty())
+    {
+        char top = stackContent.back();
+        stackContent.pop_back();
+        // Non-terminal: pop it and push its production in reverse order;
+        // terminal: pop it while reading the matching input symbol
+        if (G.rules.count(top))
+        {
+            int r = applied[next++];
+            std::string prod;
+            for (int slot = G.first[r]; G.symbol[slot] >= 0; slot++)
+                prod += (char)G.symbol[slot];
+            stackContent.append(prod.rbegin(), prod.rend());
+        }
+        path += " -> [" + stackContent + "]";
+    }
+    std::cout << "\nString accepted!\nTransitions:\n";
+    std::cout << path << "\n";
+    return stats.result(true);
+}
@@ -1,245 +1,202 @@
 #include <iostream>
 #include <string>
-#include <map>
 #include <vector>
-#include <set>
 #include <algorithm>
+#include "grammar.h"
 using namespace std;
 
-// Simple structure to hold grammar data
-struct Grammar
-{
-    string start;                              // starting symbol (like "S")
-    map<string, vector<vector<string>>> rules; // rules: A → α | β ...
-};
-
-// Check if a string is a terminal (lowercase single character)
-bool isTerminal(const string &s) { return s.size() == 1 && islower(s[0]); }
-
-// Check if a string is a nonterminal (uppercase single character)
-bool isNonTerminal(const string &s) { return s.size() == 1 && isupper(s[0]); }
-
 // Pretty-print the grammar so we can visualize transformations
 void printGrammar(const Grammar &G, const string &title = "")
 {
     if (!title.empty())
         cout << "\n"
              << title << ":\n";
-    for (auto &[lhs, rhss] : G.rules)
-    {
-        cout << lhs << " → ";
-        for (size_t i = 0; i < rhss.size(); ++i)
-        {
-            for (auto &sym : rhss[i])
-                cout << sym; // print each symbol
-            if (i + 1 < rhss.size())
-                cout << " | "; // separate alternatives
-        }
-        cout << "\n";
-    }
+    printRules(G); // one line per nonterminal, alternatives separated by |
+}
+
+/* CLEANUP: REMOVE USELESS SYMBOLS
+   Drop variables that derive no terminal string or that the start
+   symbol never reaches. Done before every step and after the last,
+   since each step can leave new dead variables behind. */
+void removeUseless(Grammar &G)
+{
+    printUselessReport(cout, removeUselessSymbols(G));
 }
 
 /* STEP 1: REMOVE ε-PRODUCTIONS
-   If a nonterminal A can produce ε (the empty string),
-   then we remove it and adjust all other rules that use A. */
+   If a nonterminal A can produce ε (the empty string), directly or
+   through other nullable symbols, then we remove it and adjust all
+   other rules that use A. */
 void removeEpsilons(Grammar &G)
 {
-    set<string> nullable; // stores symbols that can produce ε
-
-    // Find all nullable symbols (A → ε)
-    for (auto &[A, rhss] : G.rules)
-        for (auto &rhs : rhss)
-            if (rhs.size() == 1 && rhs[0] == "ε")
-                nullable.insert(A);
-
-    // For each nullable symbol, add new rules that skip it
-    for (auto &A : nullable)
-        for (auto &[B, rhss] : G.rules)
-        {
-            vector<vector<string>> newRules;
-            for (auto rhs : rhss)
-                for (size_t i = 0; i < rhs.size(); ++i)
-                    // If nullable symbol appears in RHS, remove it once
-                    if (rhs[i] == A && rhs.size() > 1)
-                    {
-                        auto temp = rhs;
-                        temp.erase(temp.begin() + i);
-                        newRules.push_back(temp);
-                    }
-            // Add all newly created variations
-            rhss.insert(rhss.end(), newRules.begin(), newRules.end());
-        }
-
-    // Finally, remove direct ε rules (except if it’s the start symbol)
-    for (auto &A : nullable)
-        if (A != G.start)
-            G.rules[A].erase(remove_if(G.rules[A].begin(), G.rules[A].end(),
-                                       [](auto &r)
-                                       { return r.size() == 1 && r[0] == "ε"; }),
-                             G.rules[A].end());
-
+    eliminateEpsilonRules(G);
     printGrammar(G, "After Removing ε-Productions");
 }
 
 /* STEP 2: REMOVE UNIT PRODUCTIONS (A → B)
    Replace any single-variable productions with the
-   productions of that variable. */
+   productions of that variable. Variables on a cycle of unit
+   productions derive the same strings and are merged first. */
 void removeUnits(Grammar &G)
 {
-    bool changed = true;
-    while (changed)
-    { // repeat until stable
-        changed = false;
-        for (auto &[A, rhss] : G.rules)
-        {
-            vector<vector<string>> add; // to store new rules to add
-            for (auto &rhs : rhss)
-                // If RHS is a single nonterminal, expand it
-                if (rhs.size() == 1 && isNonTerminal(rhs[0]))
-                {
-                    string B = rhs[0];
-                    // Copy all rules of B into A
-                    for (auto &prod : G.rules[B])
-                        if (!(prod.size() == 1 && prod[0] == A)) // avoid A → A
-                            add.push_back(prod);
-                }
-
-            // Add new rules and remove old unit ones
-            size_t before = rhss.size();
-            rhss.insert(rhss.end(), add.begin(), add.end());
-            rhss.erase(remove_if(rhss.begin(), rhss.end(),
-                                 [](auto &r)
-                                 { return r.size() == 1 && isNonTerminal(r[0]); }),
-                       rhss.end());
-            // If number of rules changed, repeat loop
-            changed |= (rhss.size() != before);
-        }
-    }
+    eliminateUnitRules(G);
     printGrammar(G, "After Removing Unit Productions");
 }
 
 /* HELPER: REMOVE IMMEDIATE LEFT RECURSION (A → Aα)
    If A → Aα | β
    then replace with:
-      A → βA'
-      A' → αA' | ε */
-void removeLeftRecursion(Grammar &G, const string &A)
+      A → β | βA'
+      A' → α | αA'
+   No ε-rule is added, so the grammar stays ε-free.
+   Returns A', or A itself if A was not left-recursive. */
+Symbol removeLeftRecursion(Grammar &G, vector<Alternatives> &rules, Symbol A)
 {
-    auto &rhss = G.rules[A];
-    vector<vector<string>> alpha; // recursive parts (A → Aα)
-    vector<vector<string>> beta;  // non-recursive parts (A → β)
+    Alternatives alpha; // recursive parts (A → Aα)
+    Alternatives beta;  // non-recursive parts (A → β)
 
     // Separate recursive and non-recursive rules
-    for (auto &rhs : rhss)
-        (rhs[0] == A ? alpha : beta).push_back(rhs);
+    for (size_t k = 0; k < rules[A].size(); k++)
+        (!rules[A][k].empty() && rules[A][k][0] == A ? alpha : beta).add(rules[A][k]);
 
     if (alpha.empty())
-        return; // nothing to fix
+        return A; // nothing to fix
 
     // Create new variable A' for recursion
-    string Aprime = A + "'";
-    while (G.rules.count(Aprime))
-        Aprime += "'"; // ensure uniqueness
-
-    // Step 1: A → βA'
-    G.rules[A].clear();
-    for (auto &b : beta)
+    string name = G.name(A) + "'";
+    while (G.symbols.contains(name))
+        name += "'"; // ensure uniqueness
+    Symbol Aprime = G.symbols.intern(name);
+    rules.resize(G.symbols.size());
+
+    // Step 1: A → β | βA'
+    rules[A].clear();
+    for (size_t k = 0; k < beta.size(); k++)
     {
+        vector<Symbol> b(beta[k].begin(), beta[k].end());
+        rules[A].add(b);
         b.push_back(Aprime);
-        G.rules[A].push_back(b);
+        rules[A].add(b);
     }
 
-    // Step 2: A' → αA' | ε
-    for (auto &a : alpha)
+    // Step 2: A' → α | αA'
+    for (size_t k = 0; k < alpha.size(); k++)
     {
-        a.erase(a.begin()); // remove the first symbol (A)
+        vector<Symbol> a(alpha[k].begin() + 1, alpha[k].end()); // remove the first symbol (A)
+        if (a.empty())
+            continue; // A → A adds nothing
+        rules[Aprime].add(a);
         a.push_back(Aprime);
-        G.rules[Aprime].push_back(a);
+        rules[Aprime].add(a);
+    }
+    return Aprime;
+}
+
+/* HELPER: SUBSTITUTE LEADING VARIABLES
+   Every rule A → Bγ where expand(B) holds is replaced by B → δ
+   giving A → δγ, for all δ. ε-alternatives are dropped: the input
+   is expected to be ε-free apart from the start symbol.
+   Returns true if anything was substituted. */
+template <class Expand>
+bool substituteLeading(vector<Alternatives> &rules, Symbol A, Expand expand)
+{
+    bool substituted = false;
+    Alternatives newR;
+    for (size_t k = 0; k < rules[A].size(); k++)
+    {
+        Rhs rhs = rules[A][k];
+        if (rhs.empty() || !expand(rhs[0]))
+        {
+            newR.add(rhs);
+            continue;
+        }
+        for (size_t g = 0; g < rules[rhs[0]].size(); g++)
+        {
+            if (rules[rhs[0]][g].empty())
+                continue;
+            vector<Symbol> combo(rules[rhs[0]][g].begin(), rules[rhs[0]][g].end());
+            combo.insert(combo.end(), rhs.begin() + 1, rhs.end());
+            newR.add(combo);
+        }
+        substituted = true;
     }
-    G.rules[Aprime].push_back({"ε"});
+    rules[A] = newR;
+    return substituted;
 }
 
 /* STEP 3: CONVERT TO GNF (Greibach Normal Form)
    - Each rule must start with a terminal.
-   - Uses variable ordering and substitution.
-   - After substitution, removes left recursion.  */
+   - Forward pass, A1 .. An in order: substitute any leading Aj
+     where j < i, then remove left recursion. Every rule of Ai now
+     starts with a terminal or with some Aj where j > i.
+   - Backward pass, An .. A1: substitute the leading variables,
+     whose rules already start with terminals.
+   - Finally the new A' variables, in the order they were made:
+     theirs start with a terminal, an Aj or an earlier A'.  */
 void convertToGNF(Grammar &G)
 {
+    vector<Alternatives> rules = unpack(G);
+
     // Collect and sort all variables (deterministic order)
-    vector<string> vars;
-    for (auto &[A, _] : G.rules)
-        vars.push_back(A);
-    sort(vars.begin(), vars.end());
+    vector<Symbol> vars = nonterminalsByName(G);
+    vector<size_t> order(G.symbols.size(), vars.size()); // variable -> its index in vars
+    for (size_t i = 0; i < vars.size(); ++i)
+        order[vars[i]] = i;
 
-    // Process each variable Ai in order
+    // Forward pass: process each variable Ai in order
+    vector<Symbol> primes; // the A' variables, in the order they were made
     for (size_t i = 0; i < vars.size(); ++i)
     {
-        string Ai = vars[i];
-        bool repeat = true;
+        Symbol Ai = vars[i];
 
-        // Step 1: Substitute any leading Aj where j < i
-        while (repeat)
-        {
-            repeat = false;
-            vector<vector<string>> newR;
-            for (auto &rhs : G.rules[Ai])
-            {
-                if (isNonTerminal(rhs[0]))
-                {
-                    // find the index j of that leading symbol
-                    auto it = find(vars.begin(), vars.end(), rhs[0]);
-                    if (it != vars.end() && (size_t)distance(vars.begin(), it) < i)
-                    {
-                        // Substitute Aj → γ for all γ
-                        for (auto &gamma : G.rules[rhs[0]])
-                        {
-                            vector<string> combo = gamma;
-                            combo.insert(combo.end(), rhs.begin() + 1, rhs.end());
-                            newR.push_back(combo);
-                        }
-                        repeat = true;
-                        continue;
-                    }
-                }
-                newR.push_back(rhs);
-            }
-            G.rules[Ai] = newR;
-        }
+        // Step 1: Substitute any leading Aj where j < i, until none is left
+        while (substituteLeading(rules, Ai, [&](Symbol s) { return s < order.size() && order[s] < i; }))
+            ;
 
         // Step 2: Remove immediate left recursion for Ai
-        removeLeftRecursion(G, Ai);
+        if (Symbol Aprime = removeLeftRecursion(G, rules, Ai); Aprime != Ai)
+            primes.push_back(Aprime);
     }
 
-    // Step 3: Cleanup (keep only terminal-leading rules)
-    for (auto &[A, rhss] : G.rules)
-        rhss.erase(remove_if(rhss.begin(), rhss.end(),
-                             [](auto &r)
-                             { return r.empty() || !isTerminal(r[0]); }),
-                   rhss.end());
+    // Backward pass: An .. A1, then the A' variables
+    auto variable = [&](Symbol s) { return G.isNonTerminal(s); };
+    for (size_t i = vars.size(); i-- > 0;)
+        substituteLeading(rules, vars[i], variable);
+    for (Symbol Aprime : primes)
+        substituteLeading(rules, Aprime, variable);
 
+    // Step 3: Cleanup (keep only terminal-leading rules, and the start symbol's ε)
+    for (Symbol A = 0; A < rules.size(); A++)
+        rules[A].filter([&](Rhs r)
+                        { return r.empty() ? A == G.start : G.isTerminal(r[0]); });
+
+    pack(G, rules);
     printGrammar(G, "After Conversion to GNF");
 }
 
 int main()
 {
-    Grammar G;
-    G.start = "S";
-
-    // Example Grammar:
+    // Example Grammar (start symbol S):
     // S → AB | b
     // A → aA | a
     // B → b
-    G.rules["S"] = {{"A", "B"}, {"b"}};
-    G.rules["A"] = {{"a", "A"}, {"a"}};
-    G.rules["B"] = {{"b"}};
+    Grammar G = makeGrammar("S", {
+                                     {"S", {{"A", "B"}, {"b"}}},
+                                     {"A", {{"a", "A"}, {"a"}}},
+                                     {"B", {{"b"}}},
+                                 });
 
     cout << "\nGreibach Normal Form.\n";
 
     // Step-by-step transformation
     printGrammar(G, "Example Grammar");
+    removeUseless(G);
     removeEpsilons(G);
+    removeUseless(G);
     removeUnits(G);
+    removeUseless(G);
     convertToGNF(G);
+    removeUseless(G);
 
     cout << "\n✅ GNF Conversion Complete.\n";
     return 0;
@@ -0,0 +1,324 @@
+#pragma once
+// Greibach normal form: remove ε-rules and unit rules, then order the
+// nonterminals, substitute leading lower-ordered ones and remove immediate
+// left recursion, so that every rule starts with a terminal.
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "grammar.h"
+
+// Step 1: Remove ε-productions, with nullable symbols found transitively
+inline void removeEpsilons(Grammar &G)
+{
+    eliminateEpsilonRules(G);
+}
+
+// Step 2: Remove unit productions (A → B) through the unit-pair closure
+inline void removeUnits(Grammar &G)
+{
+    eliminateUnitRules(G);
+}
+
+// Helper: Remove immediate left recursion. A → Aα | β becomes A → β | βA'
+// and A' → α | αA', with no ε-rule, so the result stays ε-free. Returns A',
+// or A itself if A was not left-recursive.
+inline Symbol removeLeftRecursion(Grammar &G, std::vector<Alternatives> &rules, Symbol A)
+{
+    Alternatives alpha; // Recursive rules: A → Aα
+    Alternatives beta;  // Non-recursive rules: A → β
+
+    // Separate recursive and non-recursive rules
+    for (size_t k = 0; k < rules[A].size(); k++)
+        (!rules[A][k].empty() && rules[A][k][0] == A ? alpha : beta).add(rules[A][k]);
+
+    if (alpha.empty()) return A; // Nothing to do if no recursion
+
+    // Create new variable A' for recursion
+    std::string name = G.name(A) + "'";
+    while (G.symbols.contains(name)) name += "'"; // Ensure uniqueness
+    Symbol Aprime = G.symbols.intern(name);
+    rules.resize(G.symbols.size());
+
+    // Rewrite A → β | βA' and A' → α | αA'
+    rules[A].clear();
+    for (size_t k = 0; k < beta.size(); k++)
+    {
+        std::vector<Symbol> b(beta[k].begin(), beta[k].end());
+        rules[A].add(b);
+        b.push_back(Aprime);
+        rules[A].add(b);
+    }
+
+    for (size_t k = 0; k < alpha.size(); k++)
+    {
+        std::vector<Symbol> a(alpha[k].begin() + 1, alpha[k].end()); // Remove leading A
+        if (a.empty())
+            continue; // A → A derives nothing new
+        rules[Aprime].add(a);
+        a.push_back(Aprime);
+        rules[Aprime].add(a);
+    }
+    return Aprime;
+}
+
+// Replace every rule of A that starts with a variable B with expand(B) by B's rules
+// followed by the rest (B → ε is skipped: the input is ε-free apart from the
+// start symbol). False if A ends up with more than maxRules rules (0 = no
+// limit).
+template <class Expand>
+bool substituteLeading(std::vector<Alternatives> &rules, Symbol A, Expand expand, size_t maxRules)
+{
+    Alternatives newR;
+    for (size_t k = 0; k < rules[A].size(); k++)
+    {
+        Rhs rhs = rules[A][k];
+        if (rhs.empty() || !expand(rhs[0]))
+        {
+            newR.add(rhs);
+            continue;
+        }
+        for (size_t g = 0; g < rules[rhs[0]].size(); g++)
+        {
+            if (rules[rhs[0]][g].empty())
+                continue;
+            std::vector<Symbol> combo(rules[rhs[0]][g].begin(), rules[rhs[0]][g].end());
+            combo.insert(combo.end(), rhs.begin() + 1, rhs.end());
+            newR.add(combo);
+        }
+    }
+    if (maxRules && newR.size() > maxRules)
+        return false;
+    rules[A] = newR;
+    return true;
+}
+
+// Step 3: Convert to GNF (Paull's algorithm) on an ε-free grammar without
+// unit rules. With the variables ordered A1 .. An, a forward pass makes
+// every rule of Ai start with a terminal or some Aj, j > i: leading Aj with
+// j < i are substituted, then immediate left recursion is removed. A
+// backward pass then substitutes the leading variables of An-1 .. A1, whose
+// rules are in GNF by then. A rule of a new variable Ai' starts with a
+// terminal, an original variable or some Aj' created before it, so the new
+// variables are finished last, in creation order. The output can grow
+// exponentially with the number of variables; with maxRules > 0, gives up
+// (returning false, G unchanged) once one variable has more rules than that.
+inline bool convertToGNF(Grammar &G, size_t maxRules = 0)
+{
+    std::vector<Alternatives> rules = unpack(G);
+
+    // Collect variables in deterministic order
+    std::vector<Symbol> vars = nonterminalsByName(G);
+    std::vector<size_t> order(G.symbols.size(), vars.size()); // Variable -> index in vars
+    for (size_t i = 0; i < vars.size(); ++i)
+        order[vars[i]] = i;
+    auto rank = [&](Symbol s) { return s < order.size() ? order[s] : vars.size(); };
+
+    // Forward pass
+    std::vector<Symbol> primes; // New variables, in creation order
+    for (size_t i = 0; i < vars.size(); ++i)
+    {
+        Symbol Ai = vars[i];
+
+        // Substitute leading variables Aj (j < i) until none is left; each
+        // round raises the lowest leading index
+        auto lower = [&](Symbol s) { return rank(s) < i; };
+        auto anyLower = [&]() {
+            for (size_t k = 0; k < rules[Ai].size(); k++)
+                if (!rules[Ai][k].empty() && lower(rules[Ai][k][0]))
+                    return true;
+            return false;
+        };
+        while (anyLower())
+            if (!substituteLeading(rules, Ai, lower, maxRules))
+                return false;
+
+        // Remove immediate left recursion for Ai
+        if (Symbol Aprime = removeLeftRecursion(G, rules, Ai); Aprime != Ai)
+            primes.push_back(Aprime);
+    }
+
+    // Backward pass: every Aj with j > i is in GNF when Ai is substituted
+    for (size_t i = vars.size(); i-- > 0;)
+        if (!substituteLeading(rules, vars[i], [&](Symbol s) { return G.isNonTerminal(s); }, maxRules))
+            return false;
+    for (Symbol Aprime : primes)
+        if (!substituteLeading(rules, Aprime, [&](Symbol s) { return G.isNonTerminal(s); }, maxRules))
+            return false;
+
+    // Every rule now starts with a terminal, apart from the start symbol's ε
+    for (Symbol A = 0; A < rules.size(); A++)
+        rules[A].filter([&](Rhs r) { return r.empty() ? A == G.start : G.isTerminal(r[0]); });
+    pack(G, rules);
+    return true;
+}
+
+// Step 3, alternative: GNF by Rosenkrantz's matrix method, with output size
+// polynomial in the input. Write the rules as A = A·R + T over the vector A
+// of variables: R[i][j] holds the tails α of rules Aj → Ai α, T[j] the rules
+// of Aj that start with a terminal. The solution is A = T + T·Q with new
+// variables Q = R + R·Q, that is
+//   Aj → β          for β in T[j]
+//   Aj → β Qij      for β in T[i]
+//   Qij → α         for α in R[i][j]
+//   Qij → α Qkj     for α in R[i][k]
+// Every Aj rule now starts with a terminal. A Q rule starts with its tail α,
+// which is substituted once more if it starts with a variable. Only the Qij
+// that derive something (R has a path from i to j) and are reachable from
+// the start symbol are built.
+//
+// Expects an ε-free grammar without unit rules (steps 1 and 2); S → ε is
+// kept as is.
+inline void convertToGNFMatrix(Grammar &G)
+{
+    size_t N = G.symbols.size();
+    std::vector<uint32_t> leftBegin(N + 1, 0), left; // R as a graph: i → j if some Aj → Ai α
+    std::vector<std::vector<uint32_t>> tails(N);   // Per i: productions Aj → Ai α
+    for (Symbol A = 0; A < N; A++)
+        for (uint32_t p = G.firstRule(A); p < G.lastRule(A); p++)
+            if (!G.production(p).empty() && G.isNonTerminal(G.production(p)[0]))
+                tails[G.production(p)[0]].push_back(p);
+    std::vector<Symbol> lhs(G.productionCount());
+    for (Symbol A = 0; A < N; A++)
+        for (uint32_t p = G.firstRule(A); p < G.lastRule(A); p++)
+            lhs[p] = A;
+    for (Symbol i = 0; i < N; i++)
+    {
+        leftBegin[i] = left.size();
+        for (uint32_t p : tails[i])
+            left.push_back(lhs[p]);
+    }
+    leftBegin[N] = left.size();
+
+    // Qij derives something iff i reaches j by a path of one edge or more:
+    // row i of `plus` is the closure rows of i's successors ORed together
+    Reachability reach = reachability(N, leftBegin, left, [](Symbol) { return true; });
+    std::vector<uint64_t> plus(N * reach.words, 0);
+    for (Symbol i = 0; i < N; i++)
+        for (uint32_t e = leftBegin[i]; e < leftBegin[i + 1]; e++)
+            for (size_t w = 0; w < reach.words; w++)
+                plus[i * reach.words + w] |= reach.row(left[e])[w];
+    auto derives = [&](Symbol i, Symbol j) { return plus[i * reach.words + j / 64] >> (j % 64) & 1; };
+
+    std::vector<Alternatives> rules(N);
+    std::vector<uint8_t> queued(N, 0);
+    std::vector<Symbol> work;
+    std::unordered_map<uint64_t, Symbol> qVars; // (i, j) -> Qij
+    std::vector<std::pair<Symbol, Symbol>> qOf;  // Per symbol id >= N: its (i, j)
+    int qCount = 0;
+    auto need = [&](Symbol s) {
+        if (s >= queued.size())
+            queued.resize(s + 1, 0);
+        if (G.isNonTerminal(s) && !queued[s])
+            queued[s] = 1, work.push_back(s);
+    };
+    auto Q = [&](Symbol i, Symbol j) {
+        auto [it, fresh] = qVars.try_emplace((uint64_t)i << 32 | j, 0);
+        if (fresh)
+        {
+            std::string name;
+            do
+                name = "Q" + std::to_string(++qCount);
+            while (G.symbols.contains(name));
+            it->second = G.symbols.intern(name);
+            qOf.resize(G.symbols.size() - N);
+            qOf[it->second - N] = {i, j};
+        }
+        need(it->second);
+        return it->second;
+    };
+
+    // New rules of an original variable Aj, all starting with a terminal
+    std::vector<Alternatives> startRules(N);
+    std::vector<uint8_t> built(N, 0);
+    std::vector<Symbol> r;
+    auto rulesOf = [&](Symbol j) -> const Alternatives & {
+        if (built[j])
+            return startRules[j];
+        built[j] = 1;
+        for (Symbol i = 0; i < N; i++)
+        {
+            if (G.isTerminal(i) || (i != j && !derives(i, j)))
+                continue;
+            bool viaQ = derives(i, j);
+            for (uint32_t p = G.firstRule(i); p < G.lastRule(i); p++)
+            {
+                Rhs beta = G.production(p);
+                if (beta.empty() || G.isNonTerminal(beta[0]))
+                    continue;
+                if (i == j)
+                    startRules[j].add(beta);
+                if (viaQ)
+                {
+                    r.assign(beta.begin(), beta.end());
+                    r.push_back(Q(i, j));
+                    startRules[j].add(r);
+                }
+            }
+        }
+        return startRules[j];
+    };
+
+    // Add α (then `last`, if any) to `out`, substituting α's leading variable
+    auto addTail = [&](Rhs alpha, Symbol last, Alternatives &out) {
+        const Alternatives &heads = rulesOf(alpha[0]);
+        for (size_t h = 0; h < heads.size(); h++)
+        {
+            r.assign(heads[h].begin(), heads[h].end());
+            r.insert(r.end(), alpha.begin(), alpha.end());
+            r.erase(r.begin() + heads[h].size()); // Drop the substituted variable
+            if (last != Reachability::none)
+                r.push_back(last);
+            out.add(r);
+        }
+    };
+    auto addTailRaw = [&](Rhs alpha, Symbol last, Alternatives &out) {
+        if (G.isNonTerminal(alpha[0]))
+            return addTail(alpha, last, out);
+        r.assign(alpha.begin(), alpha.end());
+        if (last != Reachability::none)
+            r.push_back(last);
+        out.add(r);
+    };
+
+    need(G.start);
+    while (!work.empty())
+    {
+        Symbol s = work.back();
+        work.pop_back();
+        rules.resize(G.symbols.size());
+        Alternatives out;
+        if (s < N)
+        {
+            // Original variable: its terminal-leading rules (and S → ε)
+            const Alternatives &mine = rulesOf(s);
+            out = mine;
+            if (s == G.start)
+                for (uint32_t p = G.firstRule(s); p < G.lastRule(s); p++)
+                    if (G.production(p).empty())
+                        out.add(G.production(p));
+        }
+        else
+        {
+            auto [i, j] = qOf[s - N];
+            for (uint32_t p : tails[i])
+            {
+                Rhs alpha = G.production(p);
+                Rhs rest{alpha.begin() + 1, alpha.end()}; // α, with Ai dropped
+                if (rest.empty())
+                    continue; // A unit rule: not expected here
+                Symbol k = lhs[p];
+                if (k == j)
+                    addTailRaw(rest, Reachability::none, out);
+                if (derives(k, j))
+                    addTailRaw(rest, Q(k, j), out);
+            }
+        }
+        for (size_t k = 0; k < out.size(); k++)
+            for (Symbol x : out[k])
+                need(x);
+        rules.resize(G.symbols.size());
+        rules[s] = std::move(out);
+    }
+    rules.resize(G.symbols.size());
+    pack(G, rules);
+}
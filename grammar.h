@@ -0,0 +1,808 @@
+#pragma once
+// Grammar representation shared by the CNF and GNF converters.
+// Symbols are interned once into dense uint32 ids carrying a terminal bit, and
+// productions are stored CSR-style: the rules of nonterminal A are productions
+// ruleBegin[A] .. ruleBegin[A + 1], and production p is the symbol run
+// rhs[rhsBegin[p] .. rhsBegin[p + 1]). An empty run is an ε-production.
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+using Symbol = uint32_t;
+
+struct SymbolTable
+{
+    std::vector<std::string> names;            // Id -> name
+    std::vector<uint8_t> terminal;             // Id -> 1 if terminal
+    std::unordered_map<std::string, Symbol> ids; // Name -> id
+
+    // Names starting with an uppercase letter (S, X1, A', ...) are nonterminals
+    Symbol intern(const std::string &name)
+    {
+        auto [it, fresh] = ids.try_emplace(name, (Symbol)names.size());
+        if (fresh)
+        {
+            names.push_back(name);
+            terminal.push_back(!(isupper((unsigned char)name[0])));
+        }
+        return it->second;
+    }
+
+    bool contains(const std::string &name) const { return ids.count(name) != 0; }
+    size_t size() const { return names.size(); }
+    void reserve(size_t n)
+    {
+        names.reserve(n);
+        terminal.reserve(n);
+        ids.reserve(n);
+    }
+};
+
+// Read-only view of one right-hand side
+struct Rhs
+{
+    const Symbol *first = nullptr, *last = nullptr;
+    const Symbol *begin() const { return first; }
+    const Symbol *end() const { return last; }
+    size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+    Symbol operator[](size_t i) const { return first[i]; }
+    bool operator==(const Rhs &o) const { return std::equal(first, last, o.first, o.last); }
+};
+
+struct Grammar
+{
+    SymbolTable symbols;
+    Symbol start = 0;
+    std::vector<uint32_t> ruleBegin{0}; // Per symbol, plus one
+    std::vector<uint32_t> rhsBegin{0};  // Per production, plus one
+    std::vector<Symbol> rhs;            // Every right-hand side, back to back
+
+    bool isTerminal(Symbol s) const { return symbols.terminal[s]; }
+    bool isNonTerminal(Symbol s) const { return !symbols.terminal[s]; }
+    const std::string &name(Symbol s) const { return symbols.names[s]; }
+    size_t symbolCount() const { return symbols.size(); }
+
+    // Productions of A are production(p) for p in [firstRule(A), lastRule(A))
+    uint32_t firstRule(Symbol A) const { return A + 1 < ruleBegin.size() ? ruleBegin[A] : 0; }
+    uint32_t lastRule(Symbol A) const { return A + 1 < ruleBegin.size() ? ruleBegin[A + 1] : 0; }
+    size_t ruleCount(Symbol A) const { return lastRule(A) - firstRule(A); }
+    size_t productionCount() const { return rhsBegin.size() - 1; }
+    Rhs production(uint32_t p) const { return {rhs.data() + rhsBegin[p], rhs.data() + rhsBegin[p + 1]}; }
+};
+
+// Alternatives of one nonterminal, flat: alternative k is
+// syms[offsets[k] .. offsets[k + 1]). Passes edit a grammar through one of
+// these per nonterminal and pack the result back into CSR form. An empty list
+// owns no heap memory, so one can be kept for every symbol.
+struct Alternatives
+{
+    std::vector<uint32_t> offsets; // Empty, or one more than the alternative count
+    std::vector<Symbol> syms;
+
+    size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    bool empty() const { return size() == 0; }
+    Rhs operator[](size_t k) const { return {syms.data() + offsets[k], syms.data() + offsets[k + 1]}; }
+    void add(const Symbol *first, const Symbol *last)
+    {
+        if (offsets.empty())
+            offsets.push_back(0);
+        syms.insert(syms.end(), first, last);
+        offsets.push_back(syms.size());
+    }
+    void add(Rhs r) { add(r.first, r.last); }
+    void add(const std::vector<Symbol> &r) { add(r.data(), r.data() + r.size()); }
+    void add(std::initializer_list<Symbol> r) { add(r.begin(), r.end()); }
+    void append(const Alternatives &o)
+    {
+        for (size_t k = 0; k < o.size(); k++)
+            add(o[k]);
+    }
+    void clear()
+    {
+        offsets.clear();
+        syms.clear();
+    }
+    // Keep only the alternatives for which keep(rhs) holds, in order
+    template <class Keep>
+    void filter(Keep keep)
+    {
+        Alternatives kept;
+        for (size_t k = 0; k < size(); k++)
+            if (keep((*this)[k]))
+                kept.add((*this)[k]);
+        *this = std::move(kept);
+    }
+};
+
+// Copy every nonterminal's productions out of the CSR arrays (indexed by symbol)
+inline std::vector<Alternatives> unpack(const Grammar &G)
+{
+    std::vector<Alternatives> lists(G.symbols.size());
+    for (Symbol A = 0; A < G.symbols.size(); A++)
+        for (uint32_t p = G.firstRule(A); p < G.lastRule(A); p++)
+            lists[A].add(G.production(p));
+    return lists;
+}
+
+// Rebuild the CSR arrays from per-nonterminal lists (indexed by symbol)
+inline void pack(Grammar &G, const std::vector<Alternatives> &lists)
+{
+    G.ruleBegin.assign(1, 0);
+    G.rhsBegin.assign(1, 0);
+    G.rhs.clear();
+    for (Symbol A = 0; A < G.symbols.size(); A++)
+    {
+        if (A < lists.size())
+            for (size_t k = 0; k < lists[A].size(); k++)
+            {
+                Rhs r = lists[A][k];
+                G.rhs.insert(G.rhs.end(), r.begin(), r.end());
+                G.rhsBegin.push_back(G.rhs.size());
+            }
+        G.ruleBegin.push_back(G.rhsBegin.size() - 1);
+    }
+}
+
+// Nonterminals that have productions, ordered by name. Works on a Grammar or
+// on any read-only view with the same accessors (GrammarView in artifact.h).
+template <class AnyGrammar>
+std::vector<Symbol> nonterminalsByName(const AnyGrammar &G)
+{
+    std::vector<Symbol> out;
+    for (Symbol A = 0; A < G.symbolCount(); A++)
+        if (G.isNonTerminal(A) && G.ruleCount(A) > 0)
+            out.push_back(A);
+    std::sort(out.begin(), out.end(), [&](Symbol a, Symbol b) { return G.name(a) < G.name(b); });
+    return out;
+}
+
+// Nonterminals with a production whose symbols are all `given` or found
+// themselves (closure, 1 per symbol id), in O(|G|): every production counts
+// its symbols not yet known, and each symbol found decrements the
+// productions it occurs in. A production whose count drops to zero adds its
+// left-hand side.
+inline std::vector<uint8_t> derivingSymbols(const Grammar &G, std::vector<uint8_t> found)
+{
+    size_t N = G.symbols.size(), P = G.productionCount();
+    std::vector<uint32_t> pending(P, 0), lhs(P);
+    std::vector<uint32_t> useBegin(N + 1, 0), uses(G.rhs.size()); // Occurrences of each symbol, CSR
+    std::vector<Symbol> work;
+    for (Symbol A = 0; A < N; A++)
+        for (uint32_t p = G.firstRule(A); p < G.lastRule(A); p++)
+        {
+            lhs[p] = A;
+            for (Symbol s : G.production(p))
+                if (!found[s])
+                    pending[p]++, useBegin[s + 1]++;
+            if (pending[p] == 0 && !found[A])
+                found[A] = 1, work.push_back(A);
+        }
+    for (size_t s = 0; s < N; s++)
+        useBegin[s + 1] += useBegin[s];
+    std::vector<uint32_t> fill(useBegin.begin(), useBegin.end() - 1);
+    for (uint32_t p = 0; p < P; p++)
+        for (Symbol s : G.production(p))
+            if (fill[s] < useBegin[s + 1])
+                uses[fill[s]++] = p;
+
+    while (!work.empty())
+    {
+        Symbol B = work.back();
+        work.pop_back();
+        for (uint32_t u = useBegin[B]; u < useBegin[B + 1]; u++)
+            if (--pending[uses[u]] == 0 && !found[lhs[uses[u]]])
+                found[lhs[uses[u]]] = 1, work.push_back(lhs[uses[u]]);
+    }
+    return found;
+}
+
+// Nonterminals that derive ε
+inline std::vector<uint8_t> nullableSymbols(const Grammar &G)
+{
+    return derivingSymbols(G, std::vector<uint8_t>(G.symbols.size(), 0));
+}
+
+// Symbols that derive some string of terminals (terminals included)
+inline std::vector<uint8_t> generatingSymbols(const Grammar &G)
+{
+    return derivingSymbols(G, G.symbols.terminal);
+}
+
+// What removeUselessSymbols dropped
+struct UselessReport
+{
+    size_t nonGenerating = 0; // Nonterminals with rules that derive no terminal string
+    size_t unreachable = 0;   // Generating nonterminals with rules the start symbol never reaches
+    size_t rules = 0;         // Productions dropped
+    bool emptyLanguage = false; // The start symbol itself derives nothing
+
+    UselessReport &operator+=(const UselessReport &o)
+    {
+        nonGenerating += o.nonGenerating, unreachable += o.unreachable, rules += o.rules;
+        emptyLanguage |= o.emptyLanguage;
+        return *this;
+    }
+    bool empty() const { return rules == 0; }
+};
+
+// Drop the rules of useless nonterminals, in O(|G|): first every rule that
+// uses a non-generating symbol, then the rules of nonterminals the start
+// symbol can't reach through the rules left. The symbol table is unchanged,
+// so ids stay valid. Passes that rewrite rules can make more symbols
+// useless (ε-removal leaves A → ε-only variables without rules, unit
+// removal bypasses variables), so pipelines call this again after them.
+inline UselessReport removeUselessSymbols(Grammar &G)
+{
+    size_t N = G.symbols.size();
+    std::vector<uint8_t> generating = generatingSymbols(G);
+    auto usable = [&](uint32_t p) {
+        for (Symbol s : G.production(p))
+            if (!generating[s])
+                return false;
+        return true;
+    };
+
+    // Depth-first search from the start symbol over the usable rules
+    std::vector<uint8_t> reachable(N, 0);
+    std::vector<Symbol> work;
+    if (generating[G.start])
+        reachable[G.start] = 1, work.push_back(G.start);
+    while (!work.empty())
+    {
+        Symbol A = work.back();
+        work.pop_back();
+        for (uint32_t p = G.firstRule(A); p < G.lastRule(A); p++)
+            if (usable(p))
+                for (Symbol s : G.production(p))
+                    if (!reachable[s])
+                        reachable[s] = 1, work.push_back(s);
+    }
+
+    // Rebuild the CSR arrays with the rules that are left
+    UselessReport report;
+    report.emptyLanguage = !generating[G.start];
+    std::vector<uint32_t> ruleBegin{0}, rhsBegin{0};
+    std::vector<Symbol> rhs;
+    for (Symbol A = 0; A < N; A++)
+    {
+        if (G.ruleCount(A) > 0 && !generating[A])
+            report.nonGenerating++;
+        else if (G.ruleCount(A) > 0 && !reachable[A])
+            report.unreachable++;
+        for (uint32_t p = G.firstRule(A); p < G.lastRule(A); p++)
+            if (reachable[A] && usable(p))
+            {
+                rhs.insert(rhs.end(), G.production(p).begin(), G.production(p).end());
+                rhsBegin.push_back(rhs.size());
+            }
+            else
+                report.rules++;
+        ruleBegin.push_back(rhsBegin.size() - 1);
+    }
+    G.ruleBegin.swap(ruleBegin), G.rhsBegin.swap(rhsBegin), G.rhs.swap(rhs);
+    return report;
+}
+
+// Print "Removed ..." for a non-empty report
+inline void printUselessReport(std::ostream &out, const UselessReport &r)
+{
+    if (!r.empty())
+        out << "(Removed " << r.nonGenerating << " non-generating and " << r.unreachable
+            << " unreachable variables, " << r.rules << " rules)\n";
+    if (r.emptyLanguage)
+        out << "(The start symbol derives no string of terminals: the language is empty)\n";
+}
+
+// Hash of a symbol sequence, for hash-consing right-hand sides
+struct SymbolsHash
+{
+    size_t operator()(const std::vector<Symbol> &v) const
+    {
+        uint64_t h = v.size();
+        for (Symbol s : v)
+            h = (h ^ s) * 0x9E3779B97F4A7C15ULL, h ^= h >> 32;
+        return h;
+    }
+};
+
+// Add to `out` every non-empty variant of `r` with some of its nullable
+// occurrences left out, `r` itself first. Variants of one rule that come out
+// equal (A → BB drops either B) are added once. There are up to 2^k variants
+// for k nullable occurrences; eliminateEpsilonRules keeps k ≤ maxNullableOccurrences.
+constexpr size_t maxNullableOccurrences = 16;
+inline void addNullableVariants(Rhs r, const std::vector<uint8_t> &nullable, Alternatives &out)
+{
+    std::vector<size_t> optional;
+    for (size_t i = 0; i < r.size(); i++)
+        if (nullable[r[i]])
+            optional.push_back(i);
+    std::unordered_set<std::vector<Symbol>, SymbolsHash> seen;
+    std::vector<Symbol> variant;
+    for (uint64_t drop = 0; drop < (1ULL << optional.size()); drop++)
+    {
+        variant.clear();
+        for (size_t i = 0, k = 0; i < r.size(); i++)
+            if (k < optional.size() && optional[k] == i)
+            {
+                if (!(drop >> k++ & 1))
+                    variant.push_back(r[i]);
+            }
+            else
+                variant.push_back(r[i]);
+        if (!variant.empty() && seen.insert(variant).second)
+            out.add(variant);
+    }
+}
+
+// Reflexive-transitive closure of a graph given in CSR form (the successors
+// of v are edges[edgeBegin[v] .. edgeBegin[v + 1])). The graph is condensed
+// into strongly connected components, which share one row of the closure; a
+// component's row is its members ORed with the rows of its successors, a
+// word at a time.
+struct Reachability
+{
+    static constexpr uint32_t none = ~0u;
+    std::vector<uint32_t> component; // Per vertex; none for vertices left out
+    std::vector<uint32_t> leader;    // Per component: its lowest member
+    size_t words = 0;                // 64-bit words per row
+    std::vector<uint64_t> rows;      // [component][words]: bit w is set if v reaches w
+
+    bool has(uint32_t v, uint32_t w) const
+    {
+        return component[v] != none && (rows[component[v] * words + w / 64] >> (w % 64) & 1);
+    }
+    const uint64_t *row(uint32_t v) const { return &rows[component[v] * words]; }
+    // Call f(w) for every w that v reaches, in increasing order
+    template <class F>
+    void forEach(uint32_t v, F f) const
+    {
+        if (component[v] == none)
+            return;
+        const uint64_t *r = row(v);
+        for (size_t k = 0; k < words; k++)
+            for (uint64_t bits = r[k]; bits; bits &= bits - 1)
+                f((uint32_t)(k * 64 + __builtin_ctzll(bits)));
+    }
+};
+
+// Closure over the vertices v < n with include(v); edges must stay within them
+template <class Include>
+Reachability reachability(size_t n, const std::vector<uint32_t> &edgeBegin, const std::vector<uint32_t> &edges,
+                          Include include)
+{
+    Reachability U;
+    U.words = (n + 63) / 64;
+    U.component.assign(n, Reachability::none);
+
+    // Tarjan's algorithm, iterative. Components are completed sinks first, so
+    // the rows of a component's successors are final when it is closed.
+    const uint32_t unvisited = ~0u;
+    std::vector<uint32_t> index(n, unvisited), low(n);
+    std::vector<uint8_t> onStack(n, 0);
+    std::vector<uint32_t> stack;
+    std::vector<std::pair<uint32_t, uint32_t>> calls; // Vertex, next edge
+    uint32_t counter = 0, components = 0;
+    for (uint32_t root = 0; root < n; root++)
+    {
+        if (!include(root) || index[root] != unvisited)
+            continue;
+        index[root] = low[root] = counter++;
+        stack.push_back(root), onStack[root] = 1;
+        calls.push_back({root, edgeBegin[root]});
+        while (!calls.empty())
+        {
+            uint32_t v = calls.back().first;
+            if (calls.back().second < edgeBegin[v + 1])
+            {
+                uint32_t w = edges[calls.back().second++];
+                if (index[w] == unvisited)
+                {
+                    index[w] = low[w] = counter++;
+                    stack.push_back(w), onStack[w] = 1;
+                    calls.push_back({w, edgeBegin[w]});
+                }
+                else if (onStack[w])
+                    low[v] = std::min(low[v], index[w]);
+                continue;
+            }
+            calls.pop_back();
+            if (!calls.empty())
+                low[calls.back().first] = std::min(low[calls.back().first], low[v]);
+            if (low[v] != index[v])
+                continue;
+
+            // v roots a component: pop its members, then OR in the successors
+            uint32_t c = components++;
+            U.rows.resize(components * U.words, 0);
+            size_t top = stack.size();
+            do
+                top--;
+            while (stack[top] != v);
+            U.leader.push_back(v);
+            for (size_t i = top; i < stack.size(); i++)
+            {
+                uint32_t m = stack[i];
+                onStack[m] = 0, U.component[m] = c;
+                U.rows[c * U.words + m / 64] |= 1ULL << (m % 64);
+                U.leader[c] = std::min(U.leader[c], m);
+            }
+            for (size_t i = top; i < stack.size(); i++)
+                for (uint32_t e = edgeBegin[stack[i]]; e < edgeBegin[stack[i] + 1]; e++)
+                {
+                    uint32_t d = U.component[edges[e]];
+                    if (d == c)
+                        continue;
+                    uint64_t *row = &U.rows[c * U.words];
+                    const uint64_t *from = &U.rows[d * U.words];
+                    for (size_t k = 0; k < U.words; k++)
+                        row[k] |= from[k];
+                }
+            stack.resize(top);
+        }
+    }
+    return U;
+}
+
+// Unit pairs A ⇒* B, derived through unit rules A → B only (A ⇒* A for every
+// nonterminal). A component whose members include the start symbol has it
+// as its leader.
+using UnitPairs = Reachability;
+
+inline UnitPairs unitPairs(const Grammar &G)
+{
+    size_t N = G.symbols.size();
+    std::vector<uint32_t> edgeBegin(N + 1, 0); // Unit graph, CSR: A → B for each rule A → B
+    std::vector<Symbol> edges;
+    for (Symbol A = 0; A < N; A++)
+    {
+        edgeBegin[A] = edges.size();
+        for (uint32_t p = G.firstRule(A); p < G.lastRule(A); p++)
+        {
+            Rhs r = G.production(p);
+            if (r.size() == 1 && G.isNonTerminal(r[0]))
+                edges.push_back(r[0]);
+        }
+    }
+    edgeBegin[N] = edges.size();
+
+    UnitPairs U = reachability(N, edgeBegin, edges, [&](Symbol A) { return G.isNonTerminal(A); });
+    if (U.component[G.start] != UnitPairs::none)
+        U.leader[U.component[G.start]] = G.start;
+    return U;
+}
+
+// Remove every ε-rule except S → ε when S is nullable: each rule gets a
+// variant for every subset of its nullable occurrences left out. A rule with
+// more than maxNullableOccurrences of them is split first, A → X1 X2 ... Xn
+// becoming A → X1 E1, E1 → X2 E2, ..., En-2 → Xn-1 Xn with fresh variables,
+// so it gets at most 4 variants per piece instead of 2^k. (The CNF pipeline
+// binarizes before this pass, so there every rule has at most 2.)
+inline void eliminateEpsilonRules(Grammar &G)
+{
+    std::vector<uint8_t> nullable = nullableSymbols(G);
+    if (std::find(nullable.begin(), nullable.end(), 1) == nullable.end())
+        return; // Nothing to rewrite
+    size_t N = G.symbols.size();
+    std::vector<Alternatives> rules(N);
+    std::vector<Symbol> chain; // Scratch copy of a rule being split
+    int splitCount = 0;
+    for (Symbol A = 0; A < N; A++)
+        for (uint32_t p = G.firstRule(A); p < G.lastRule(A); p++)
+        {
+            Rhs r = G.production(p);
+            if ((size_t)std::count_if(r.begin(), r.end(), [&](Symbol s) { return nullable[s]; }) <=
+                maxNullableOccurrences)
+            {
+                addNullableVariants(r, nullable, rules[A]);
+                continue;
+            }
+            // Fold the tail from the right: Xi ... Xn becomes one variable,
+            // nullable if all of Xi ... Xn are
+            chain.assign(r.begin(), r.end());
+            Symbol tail = chain.back();
+            for (size_t i = chain.size() - 2; i >= 1; i--)
+            {
+                std::string name;
+                do name = "E" + std::to_string(++splitCount); while (G.symbols.contains(name));
+                Symbol E = G.symbols.intern(name);
+                nullable.push_back(nullable[chain[i]] && nullable[tail]);
+                rules.resize(G.symbols.size());
+                Symbol piece[2] = {chain[i], tail};
+                addNullableVariants({piece, piece + 2}, nullable, rules[E]);
+                tail = E;
+            }
+            Symbol piece[2] = {chain[0], tail};
+            addNullableVariants({piece, piece + 2}, nullable, rules[A]);
+        }
+    if (nullable[G.start])
+        rules[G.start].add({});
+    pack(G, rules);
+}
+
+// Remove every unit rule A → B. Nonterminals on a cycle of unit rules derive
+// the same strings, so each cycle is first merged into its leader (every
+// occurrence of a member is renamed); without that, a cycle of k members
+// would copy its rules k times. Then A takes the non-unit rules of every B
+// with A ⇒* B, its own first.
+inline void eliminateUnitRules(Grammar &G)
+{
+    auto isUnit = [&](Rhs r) { return r.size() == 1 && G.isNonTerminal(r[0]); };
+    bool any = false;
+    for (size_t p = 0; p < G.productionCount() && !any; p++)
+        any = isUnit(G.production(p));
+    if (!any)
+        return; // No unit rules at all
+
+    UnitPairs units = unitPairs(G);
+    size_t N = G.symbols.size();
+    std::vector<Symbol> rename(N);
+    for (Symbol A = 0; A < N; A++)
+        rename[A] = units.component[A] == UnitPairs::none ? A : units.leader[units.component[A]];
+
+    // Non-unit rules of each cycle, collected on its leader and renamed
+    std::vector<Alternatives> merged(N);
+    std::vector<Symbol> r;
+    for (Symbol A = 0; A < N; A++)
+        for (uint32_t p = G.firstRule(A); p < G.lastRule(A); p++)
+            if (!isUnit(G.production(p)))
+            {
+                r.clear();
+                for (Symbol s : G.production(p))
+                    r.push_back(rename[s]);
+                merged[rename[A]].add(r);
+            }
+
+    std::vector<Alternatives> rules(N);
+    for (Symbol A = 0; A < N; A++)
+    {
+        if (rename[A] != A)
+            continue; // Merged into its leader
+        rules[A].append(merged[A]);
+        units.forEach(A, [&](Symbol B) {
+            if (rename[B] == B && B != A)
+                rules[A].append(merged[B]);
+        });
+    }
+    pack(G, rules);
+}
+
+// Shrink a grammar without changing its language: merge nonterminals whose
+// rule sets are equal once merged nonterminals are identified, then drop
+// duplicate rules. Equivalent nonterminals are found by partition
+// refinement: all nonterminals start in one block, and each round splits a
+// block by the members' rule sets with symbols replaced by their blocks,
+// until no block splits. This also merges mutually recursive look-alikes
+// (A → aA | b and B → aB | b), which pairwise comparison never would. Each
+// block keeps one member: the start symbol if it is one, else the lowest id.
+inline void compactGrammar(Grammar &G)
+{
+    size_t N = G.symbols.size();
+    const uint32_t none = ~0u;
+    std::vector<uint32_t> block(N, none); // Nonterminal -> block; terminals stay none
+    size_t blocks = 0;
+    for (Symbol A = 0; A < N; A++)
+        if (G.isNonTerminal(A))
+            block[A] = 0, blocks = 1;
+
+    // Signature of A: its block, then its rules sorted and deduplicated, with
+    // nonterminals written as N + block
+    std::vector<std::vector<Symbol>> mapped;
+    std::vector<Symbol> signature;
+    auto sign = [&](Symbol A) {
+        mapped.clear();
+        for (uint32_t p = G.firstRule(A); p < G.lastRule(A); p++)
+        {
+            mapped.emplace_back();
+            for (Symbol s : G.production(p))
+                mapped.back().push_back(block[s] == none ? s : N + block[s]);
+        }
+        std::sort(mapped.begin(), mapped.end());
+        mapped.erase(std::unique(mapped.begin(), mapped.end()), mapped.end());
+        signature.assign(1, block[A]);
+        for (auto &r : mapped)
+        {
+            signature.push_back(r.size());
+            signature.insert(signature.end(), r.begin(), r.end());
+        }
+    };
+    while (true)
+    {
+        std::unordered_map<std::vector<Symbol>, uint32_t, SymbolsHash> ids;
+        std::vector<uint32_t> next(N, none);
+        for (Symbol A = 0; A < N; A++)
+            if (block[A] != none)
+            {
+                sign(A);
+                next[A] = ids.try_emplace(signature, (uint32_t)ids.size()).first->second;
+            }
+        bool split = ids.size() != blocks;
+        block.swap(next), blocks = ids.size();
+        if (!split)
+            break;
+    }
+
+    std::vector<Symbol> keep(blocks, none); // Block -> the member that stays
+    for (Symbol A = 0; A < N; A++)
+        if (block[A] != none && (keep[block[A]] == none || A == G.start) && keep[block[A]] != G.start)
+            keep[block[A]] = A;
+
+    // The kept members get their rules renamed, each distinct one once
+    std::vector<Alternatives> rules(N);
+    std::unordered_set<std::vector<Symbol>, SymbolsHash> seen;
+    std::vector<Symbol> r;
+    for (Symbol A = 0; A < N; A++)
+    {
+        if (block[A] == none || keep[block[A]] != A)
+            continue;
+        seen.clear();
+        for (uint32_t p = G.firstRule(A); p < G.lastRule(A); p++)
+        {
+            r.clear();
+            for (Symbol s : G.production(p))
+                r.push_back(block[s] == none ? s : keep[block[s]]);
+            if (seen.insert(r).second)
+                rules[A].add(r);
+        }
+    }
+    pack(G, rules);
+}
+
+// Build a grammar from literal rules, e.g. {"A", {{"a", "A", "S"}, {"a"}, {"ε"}}};
+// "ε" stands for the empty right-hand side
+inline Grammar makeGrammar(const std::string &start,
+                           const std::vector<std::pair<std::string, std::vector<std::vector<std::string>>>> &rules)
+{
+    Grammar G;
+    G.start = G.symbols.intern(start);
+    std::vector<Alternatives> lists;
+    for (auto &[lhs, rhss] : rules)
+    {
+        Symbol A = G.symbols.intern(lhs);
+        for (auto &rhs : rhss)
+        {
+            std::vector<Symbol> r;
+            for (auto &sym : rhs)
+                if (sym != "ε")
+                    r.push_back(G.symbols.intern(sym));
+            lists.resize(G.symbols.size());
+            lists[A].add(r);
+        }
+    }
+    pack(G, lists);
+    return G;
+}
+
+// Build a grammar from the char-keyed rules of cfg.cpp and cfg-pda.cpp
+// (a key is a nonterminal, 'S' starts, "" is ε); every character of a
+// right-hand side is one symbol. Keys must be uppercase so the symbol table
+// sees them as nonterminals.
+inline Grammar fromCharGrammar(const std::unordered_map<char, std::vector<std::string>> &rules)
+{
+    std::vector<std::pair<std::string, std::vector<std::vector<std::string>>>> lists;
+    for (auto &[A, prods] : rules)
+    {
+        lists.push_back({std::string(1, A), {}});
+        for (const std::string &prod : prods)
+        {
+            std::vector<std::string> rhs;
+            for (char c : prod)
+                rhs.push_back(std::string(1, c));
+            lists.back().second.push_back(rhs);
+        }
+    }
+    std::sort(lists.begin(), lists.end());
+    return makeGrammar("S", lists);
+}
+
+// Print one line per nonterminal: A → α | β ..., ε for an empty alternative.
+// The start symbol comes first and the rest by name, so readGrammar reads
+// the output back with the same start symbol.
+template <class AnyGrammar>
+void printRules(const AnyGrammar &G)
+{
+    std::vector<Symbol> order = nonterminalsByName(G);
+    std::stable_partition(order.begin(), order.end(), [&](Symbol A) { return A == G.start; });
+    for (Symbol A : order)
+    {
+        std::cout << G.name(A) << " → ";
+        for (uint32_t p = G.firstRule(A); p < G.lastRule(A); p++)
+        {
+            Rhs r = G.production(p);
+            if (r.empty())
+                std::cout << "ε";
+            for (Symbol s : r)
+                std::cout << G.name(s);
+            if (p + 1 != G.lastRule(A))
+                std::cout << " | ";
+        }
+        std::cout << "\n";
+    }
+}
+
+// Read rules in the format printRules writes, one nonterminal per line:
+//   S → ASB | ε
+//   X1 → a
+// "->" may stand for "→" and '#' starts a comment. Symbols may be separated
+// by spaces; otherwise an uppercase letter followed by digits and primes is
+// one nonterminal and any other character is a one-character terminal; ε or
+// nothing at all is the empty alternative. The first left-hand side is the
+// start symbol. On a syntax error, returns false with `error` naming the line.
+inline bool readGrammar(std::istream &in, Grammar &G, std::string &error)
+{
+    G = Grammar();
+    std::vector<Alternatives> lists;
+    std::string line;
+    bool first = true;
+    for (int number = 1; std::getline(in, line); number++)
+    {
+        line = line.substr(0, line.find('#'));
+        size_t arrow = line.find("→"), width = 3;
+        if (arrow == std::string::npos)
+            arrow = line.find("->"), width = 2;
+        if (line.find_first_not_of(" \t\r") == std::string::npos)
+            continue;
+        auto fail = [&](const std::string &why) {
+            error = "line " + std::to_string(number) + ": " + why;
+            return false;
+        };
+        if (arrow == std::string::npos)
+            return fail("expected A → α | β ...");
+
+        size_t from = line.find_first_not_of(" \t"), to = line.find_last_not_of(" \t", arrow - 1);
+        if (from >= arrow || !isupper((unsigned char)line[from]))
+            return fail("the left-hand side must be a nonterminal");
+        Symbol A = G.symbols.intern(line.substr(from, to - from + 1));
+        if (first)
+            G.start = A, first = false;
+
+        std::vector<Symbol> r;
+        auto flush = [&]() {
+            lists.resize(G.symbols.size());
+            lists[A].add(r);
+            r.clear();
+        };
+        for (size_t i = arrow + width; i < line.size();)
+        {
+            unsigned char c = line[i];
+            size_t end = i + 1;
+            if (c == ' ' || c == '\t' || c == '\r')
+            {
+                i++;
+                continue;
+            }
+            if (c == '|')
+            {
+                flush();
+                i++;
+                continue;
+            }
+            if (line.compare(i, 2, "ε") == 0)
+            {
+                i += 2;
+                continue;
+            }
+            if (isupper(c))
+                while (end < line.size() && (isdigit((unsigned char)line[end]) || line[end] == '\''))
+                    end++;
+            r.push_back(G.symbols.intern(line.substr(i, end - i)));
+            i = end;
+        }
+        flush();
+    }
+    if (first)
+    {
+        error = "no rules";
+        return false;
+    }
+    lists.resize(G.symbols.size());
+    pack(G, lists);
+    return true;
+}
@@ -0,0 +1,560 @@
+#pragma once
+// LALR(1) parse tables and a shift-reduce recognizer for Grammar (grammar.h).
+// A deterministic grammar is recognized in linear time by one stack of LR
+// states instead of a search over sentential forms.
+//
+// compileLALR builds the LR(0) automaton of the grammar augmented with
+// S' → S, then computes the LALR(1) lookaheads the DeRemer–Pennello way:
+// over the nonterminal transitions (p, A) of the automaton,
+//   Read(p, A)   = DR(p, A) ∪ ⋃ { Read(r, C)   | (p, A) reads (r, C) }
+//   Follow(p, A) = Read(p, A) ∪ ⋃ { Follow(p', B) | (p, A) includes (p', B) }
+// each solved by one depth-first pass that merges strongly connected
+// components, and the lookahead of reducing A → ω in state q is the union of
+// Follow(p, A) over the transitions it looks back to. Cells claimed twice are
+// conflicts: shift wins over reduce, the lower-numbered production over the
+// other, and each is listed in `conflicts`.
+//
+// The tables are stored compressed. Each state gets a default reduction (its
+// most frequent one) and each nonterminal a default GOTO target, which leave
+// most rows nearly empty; the remaining entries of all rows are then packed
+// into one array by row displacement: row r's entry for column c sits at
+// base[r] + c and is valid when check[] there holds r. Terminals are
+// one-byte symbol names, as for the CYK tables in cnf.h.
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "artifact.h"
+#include "grammar.h"
+#include "stats.h"
+
+// A table cell two actions claimed, with the action kept and the one dropped
+// (encoded as in the ACTION table)
+struct LALRConflict
+{
+    uint32_t state;
+    Symbol terminal; // LALRTables::endOfInput for the end of the input
+    int32_t kept, dropped;
+};
+
+// ACTION entries: 0 is an error, s + 1 shifts to state s, -(p + 1) reduces by
+// production p, and reducing by the augmented production (p == productions)
+// accepts. GOTO entries are states.
+struct LALRTables
+{
+    static constexpr Symbol endOfInput = ~0u;
+
+    uint32_t states = 0, columns = 0, nonterminals = 0, productions = 0;
+    uint32_t endColumn = 0; // Column of the end of the input, the last one
+    size_t actionSize = 0, gotoSize = 0;
+    const int32_t *termColumn = nullptr; // [byte]: column of the terminal with that name, -1 if none
+    const int32_t *actionBase = nullptr, *actionDefault = nullptr; // Per state
+    const int32_t *actionCheck = nullptr, *actionValue = nullptr;  // actionSize entries
+    const int32_t *gotoBase = nullptr, *gotoDefault = nullptr;     // Per nonterminal (dense)
+    const int32_t *gotoCheck = nullptr, *gotoValue = nullptr;      // gotoSize entries
+    const uint32_t *ruleLhs = nullptr, *ruleLength = nullptr;      // Per production: dense nonterminal, |rhs|
+
+    // Storage behind the pointers when compiled in-process (compileLALR);
+    // empty when they point into a mapped artifact (viewLALRTables)
+    std::vector<int32_t> store;     // termColumn, the ACTION arrays, the GOTO arrays
+    std::vector<uint32_t> ruleStore; // ruleLhs, ruleLength
+    std::vector<LALRConflict> conflicts;  // Only known in-process
+    std::vector<Symbol> columnSymbols;    // Column -> terminal, in-process only
+
+    LALRTables() = default;
+    LALRTables(LALRTables &&) = default; // Moving a vector keeps its buffer, so the pointers stay valid
+    LALRTables &operator=(LALRTables &&) = default;
+    LALRTables(const LALRTables &) = delete;
+
+    bool deterministic() const { return conflicts.empty(); }
+
+    // The arrays are padded so base + column is always in range
+    int32_t action(uint32_t state, uint32_t column) const
+    {
+        uint32_t i = actionBase[state] + column;
+        return actionCheck[i] == (int32_t)state ? actionValue[i] : actionDefault[state];
+    }
+    uint32_t go(uint32_t state, uint32_t nonterminal) const
+    {
+        uint32_t i = gotoBase[nonterminal] + state;
+        return gotoCheck[i] == (int32_t)nonterminal ? gotoValue[i] : gotoDefault[nonterminal];
+    }
+
+    // Point the arrays into `ints` (termColumn, then the ACTION and GOTO
+    // arrays in member order) and `rules` (ruleLhs, then ruleLength)
+    void point(const int32_t *ints, const uint32_t *rules)
+    {
+        termColumn = ints, ints += 256;
+        actionBase = ints, ints += states;
+        actionDefault = ints, ints += states;
+        actionCheck = ints, ints += actionSize;
+        actionValue = ints, ints += actionSize;
+        gotoBase = ints, ints += nonterminals;
+        gotoDefault = ints, ints += nonterminals;
+        gotoCheck = ints, ints += gotoSize;
+        gotoValue = ints;
+        ruleLhs = rules, ruleLength = rules + productions;
+    }
+    size_t intCount() const { return 256 + 2 * states + 2 * actionSize + 2 * nonterminals + 2 * gotoSize; }
+};
+
+// Pack sparse rows of (column, value) into check/value arrays by first-fit
+// row displacement, largest rows first; returns each row's base. The arrays
+// get `width` slots of padding past the last base.
+inline std::vector<int32_t> displaceRows(const std::vector<std::vector<std::pair<uint32_t, int32_t>>> &rows,
+                                         uint32_t width, std::vector<int32_t> &check, std::vector<int32_t> &value)
+{
+    std::vector<uint32_t> order(rows.size());
+    for (uint32_t r = 0; r < rows.size(); r++)
+        order[r] = r;
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return rows[a].size() > rows[b].size(); });
+
+    std::vector<int32_t> base(rows.size(), 0);
+    check.clear(), value.clear();
+    size_t firstFree = 0, top = 0; // Lowest unused slot, one past the highest base
+    for (uint32_t r : order)
+    {
+        if (rows[r].empty())
+            continue;
+        uint32_t lowest = rows[r][0].first;
+        size_t b = firstFree > lowest ? firstFree - lowest : 0;
+        for (;; b++)
+        {
+            bool fits = true;
+            for (auto [column, _] : rows[r])
+                if (b + column < check.size() && check[b + column] >= 0)
+                {
+                    fits = false;
+                    break;
+                }
+            if (fits)
+                break;
+        }
+        if (check.size() < b + width)
+            check.resize(b + width, -1), value.resize(b + width, 0);
+        for (auto [column, v] : rows[r])
+            check[b + column] = r, value[b + column] = v;
+        base[r] = b, top = std::max(top, b + 1);
+        while (firstFree < check.size() && check[firstFree] >= 0)
+            firstFree++;
+    }
+    check.resize(top + width, -1), value.resize(top + width, 0);
+    return base;
+}
+
+// Depth-first closure F(x) = F(x) ∪ ⋃ { F(y) | x R y } over bit rows of
+// `words` words, where R is given per vertex. Members of a strongly
+// connected component end with the same set (DeRemer–Pennello's digraph,
+// iterative).
+inline void digraph(const std::vector<std::vector<uint32_t>> &R, std::vector<uint64_t> &F, size_t words)
+{
+    const uint32_t done = ~0u;
+    size_t X = R.size();
+    std::vector<uint32_t> depth(X, 0), stack;
+    struct Call
+    {
+        uint32_t x, next, depth; // Vertex, next edge, depth when pushed
+    };
+    std::vector<Call> calls;
+    auto unite = [&](uint32_t x, uint32_t y) {
+        for (size_t k = 0; k < words; k++)
+            F[x * words + k] |= F[y * words + k];
+    };
+    auto visit = [&](uint32_t x) {
+        stack.push_back(x), depth[x] = stack.size();
+        calls.push_back({x, 0, depth[x]});
+    };
+    for (uint32_t root = 0; root < X; root++)
+    {
+        if (depth[root])
+            continue;
+        visit(root);
+        while (!calls.empty())
+        {
+            Call &c = calls.back();
+            uint32_t x = c.x;
+            if (c.next < R[x].size())
+            {
+                uint32_t y = R[x][c.next++];
+                if (!depth[y])
+                    visit(y);
+                else
+                {
+                    depth[x] = std::min(depth[x], depth[y]);
+                    unite(x, y);
+                }
+                continue;
+            }
+            bool rootsComponent = depth[x] == c.depth;
+            calls.pop_back();
+            if (rootsComponent)
+            {
+                // x roots a component: its members share x's set
+                uint32_t top;
+                do
+                {
+                    top = stack.back();
+                    stack.pop_back();
+                    depth[top] = done;
+                    if (top != x)
+                        std::copy_n(&F[x * words], words, &F[top * words]);
+                } while (top != x);
+            }
+            if (!calls.empty())
+            {
+                uint32_t parent = calls.back().x;
+                depth[parent] = std::min(depth[parent], depth[x]);
+                unite(parent, x);
+            }
+        }
+    }
+}
+
+inline LALRTables compileLALR(const Grammar &G)
+{
+    LALRTables T;
+    size_t N = G.symbolCount(), P = G.productionCount();
+    T.productions = P;
+
+    // Production P is the augmented S' → S
+    std::vector<Symbol> lhs(P + 1, (Symbol)N);
+    for (Symbol A = 0; A < N; A++)
+        for (uint32_t p = G.firstRule(A); p < G.lastRule(A); p++)
+            lhs[p] = A;
+    auto rhsOf = [&](uint32_t p) { return p < P ? G.production(p) : Rhs{&G.start, &G.start + 1}; };
+
+    // Items are numbered densely: item itemBase[p] + d has the dot after d symbols of p
+    std::vector<uint32_t> itemBase(P + 2, 0), itemProduction;
+    for (uint32_t p = 0; p <= P; p++)
+    {
+        itemBase[p + 1] = itemBase[p] + rhsOf(p).size() + 1;
+        itemProduction.insert(itemProduction.end(), rhsOf(p).size() + 1, p);
+    }
+    auto dot = [&](uint32_t item) { return item - itemBase[itemProduction[item]]; };
+    auto afterDot = [&](uint32_t item) {
+        Rhs r = rhsOf(itemProduction[item]);
+        return dot(item) < r.size() ? r[dot(item)] : LALRTables::endOfInput;
+    };
+
+    // LR(0) automaton: states are identified by their sorted kernels
+    std::vector<std::vector<uint32_t>> kernels = {{itemBase[P]}};
+    std::unordered_map<std::vector<uint32_t>, uint32_t, SymbolsHash> stateIndex = {{kernels[0], 0}};
+    std::vector<std::vector<std::pair<Symbol, uint32_t>>> transitions; // Per state, by symbol
+    std::vector<std::vector<uint32_t>> completed;                       // Per state: productions to reduce
+    std::vector<uint32_t> added(N, ~0u);
+    for (uint32_t s = 0; s < kernels.size(); s++)
+    {
+        std::vector<uint32_t> items = kernels[s];
+        for (size_t i = 0; i < items.size(); i++)
+        {
+            Symbol B = afterDot(items[i]);
+            if (B == LALRTables::endOfInput || G.isTerminal(B) || added[B] == s)
+                continue;
+            added[B] = s;
+            for (uint32_t p = G.firstRule(B); p < G.lastRule(B); p++)
+                items.push_back(itemBase[p]);
+        }
+        std::vector<std::pair<Symbol, uint32_t>> moves; // Symbol after the dot, item moved past it
+        completed.emplace_back();
+        for (uint32_t item : items)
+            if (Symbol X = afterDot(item); X != LALRTables::endOfInput)
+                moves.push_back({X, item + 1});
+            else
+                completed[s].push_back(itemProduction[item]);
+        std::sort(moves.begin(), moves.end());
+        transitions.emplace_back();
+        for (size_t i = 0, j; i < moves.size(); i = j)
+        {
+            std::vector<uint32_t> kernel;
+            for (j = i; j < moves.size() && moves[j].first == moves[i].first; j++)
+                kernel.push_back(moves[j].second);
+            auto [it, fresh] = stateIndex.try_emplace(kernel, (uint32_t)kernels.size());
+            if (fresh)
+                kernels.push_back(kernel);
+            transitions[s].push_back({moves[i].first, it->second});
+        }
+    }
+    T.states = kernels.size();
+    auto target = [&](uint32_t s, Symbol X) {
+        auto &row = transitions[s];
+        auto it = std::lower_bound(row.begin(), row.end(), std::make_pair(X, 0u));
+        return it != row.end() && it->first == X ? it->second : ~0u;
+    };
+
+    // Columns: terminals named by one byte, then the end of the input
+    T.store.assign(256, -1);
+    for (Symbol a = 0; a < N; a++)
+        if (G.isTerminal(a) && G.name(a).size() == 1)
+        {
+            T.store[(unsigned char)G.name(a)[0]] = T.columnSymbols.size();
+            T.columnSymbols.push_back(a);
+        }
+    T.endColumn = T.columnSymbols.size();
+    T.columnSymbols.push_back(LALRTables::endOfInput);
+    T.columns = T.columnSymbols.size();
+    size_t words = (T.columns + 63) / 64;
+    auto column = [&](Symbol a) { return G.name(a).size() == 1 ? T.store[(unsigned char)G.name(a)[0]] : -1; };
+
+    // Nonterminal transitions (p, A) and their direct reads DR
+    std::vector<uint32_t> ntIndex(N, ~0u);
+    for (Symbol A = 0; A < N; A++)
+        if (G.isNonTerminal(A))
+            ntIndex[A] = T.nonterminals++;
+    struct Transition
+    {
+        uint32_t from;
+        Symbol A;
+        uint32_t to;
+    };
+    std::vector<Transition> X;
+    std::unordered_map<uint64_t, uint32_t> transitionIndex;
+    for (uint32_t s = 0; s < T.states; s++)
+        for (auto [sym, to] : transitions[s])
+            if (G.isNonTerminal(sym))
+            {
+                transitionIndex[(uint64_t)s << 32 | sym] = X.size();
+                X.push_back({s, sym, to});
+            }
+    std::vector<uint8_t> nullable = nullableSymbols(G);
+    std::vector<uint64_t> F(X.size() * words, 0);
+    std::vector<std::vector<uint32_t>> reads(X.size()), includes(X.size());
+    for (uint32_t x = 0; x < X.size(); x++)
+    {
+        for (auto [sym, to] : transitions[X[x].to])
+            if (G.isTerminal(sym) && column(sym) >= 0)
+                F[x * words + column(sym) / 64] |= 1ULL << (column(sym) % 64);
+            else if (G.isNonTerminal(sym) && nullable[sym])
+                reads[x].push_back(transitionIndex[(uint64_t)X[x].to << 32 | sym]);
+        if (X[x].from == 0 && X[x].A == G.start)
+            F[x * words + T.endColumn / 64] |= 1ULL << (T.endColumn % 64);
+    }
+    digraph(reads, F, words);
+
+    // includes and lookback: walk every production B → β A γ of each
+    // transition (p', B) from p'; A includes (p', B) where γ is nullable, and
+    // the state reached at the end reduces B → βAγ looking back to (p', B)
+    std::vector<std::vector<std::pair<uint32_t, uint32_t>>> lookback(T.states); // (production, transition)
+    for (uint32_t y = 0; y < X.size(); y++)
+        for (uint32_t p = G.firstRule(X[y].A); p < G.lastRule(X[y].A); p++)
+        {
+            Rhs r = G.production(p);
+            size_t nullableFrom = r.size(); // r[i..] is nullable for i >= nullableFrom
+            while (nullableFrom > 0 && G.isNonTerminal(r[nullableFrom - 1]) && nullable[r[nullableFrom - 1]])
+                nullableFrom--;
+            uint32_t s = X[y].from;
+            for (size_t i = 0; i < r.size(); i++)
+            {
+                if (G.isNonTerminal(r[i]) && i + 1 >= nullableFrom)
+                    includes[transitionIndex[(uint64_t)s << 32 | r[i]]].push_back(y);
+                s = target(s, r[i]);
+            }
+            lookback[s].push_back({p, y});
+        }
+    digraph(includes, F, words);
+
+    // The dense ACTION table: shifts, the accept, then the reductions under their lookaheads
+    std::vector<int32_t> action((size_t)T.states * T.columns, 0);
+    for (uint32_t s = 0; s < T.states; s++)
+        for (auto [sym, to] : transitions[s])
+            if (G.isTerminal(sym) && column(sym) >= 0)
+                action[(size_t)s * T.columns + column(sym)] = to + 1;
+    const int32_t accept = -(int32_t)(P + 1);
+    if (uint32_t s = target(0, G.start); s != ~0u)
+        action[(size_t)s * T.columns + T.endColumn] = accept;
+    std::vector<uint64_t> lookahead(words);
+    for (uint32_t s = 0; s < T.states; s++)
+        for (uint32_t p : completed[s])
+        {
+            if (p == P)
+                continue;
+            std::fill(lookahead.begin(), lookahead.end(), 0);
+            for (auto [q, y] : lookback[s])
+                if (q == p)
+                    for (size_t k = 0; k < words; k++)
+                        lookahead[k] |= F[y * words + k];
+            for (uint32_t c = 0; c < T.columns; c++)
+            {
+                if (!(lookahead[c / 64] >> (c % 64) & 1))
+                    continue;
+                int32_t &cell = action[(size_t)s * T.columns + c], reduce = -(int32_t)(p + 1);
+                if (cell == 0 || cell == reduce)
+                    cell = reduce;
+                else if (cell > 0 || cell == accept || cell > reduce)
+                    T.conflicts.push_back({s, T.columnSymbols[c], cell, reduce});
+                else
+                {
+                    T.conflicts.push_back({s, T.columnSymbols[c], reduce, cell});
+                    cell = reduce;
+                }
+            }
+        }
+
+    // Compress: default reductions and GOTO targets, then row displacement
+    std::vector<int32_t> actionDefault(T.states, 0), gotoDefault(T.nonterminals, 0);
+    std::vector<std::vector<std::pair<uint32_t, int32_t>>> actionRows(T.states), gotoRows(T.nonterminals);
+    std::unordered_map<int32_t, uint32_t> counts;
+    for (uint32_t s = 0; s < T.states; s++)
+    {
+        counts.clear();
+        uint32_t best = 0;
+        for (uint32_t c = 0; c < T.columns; c++)
+            if (int32_t a = action[(size_t)s * T.columns + c]; a < 0 && a != accept)
+                if (++counts[a] > best)
+                    best = counts[a], actionDefault[s] = a;
+        for (uint32_t c = 0; c < T.columns; c++)
+            if (int32_t a = action[(size_t)s * T.columns + c]; a != 0 && a != actionDefault[s])
+                actionRows[s].push_back({c, a});
+    }
+    std::vector<std::vector<uint32_t>> targets(T.nonterminals);
+    for (auto &x : X)
+        targets[ntIndex[x.A]].push_back(x.from), targets[ntIndex[x.A]].push_back(x.to);
+    for (uint32_t A = 0; A < T.nonterminals; A++)
+    {
+        counts.clear();
+        uint32_t best = 0;
+        for (size_t k = 1; k < targets[A].size(); k += 2)
+            if (++counts[targets[A][k]] > best)
+                best = counts[targets[A][k]], gotoDefault[A] = targets[A][k];
+        for (size_t k = 0; k < targets[A].size(); k += 2)
+            if ((int32_t)targets[A][k + 1] != gotoDefault[A])
+                gotoRows[A].push_back({targets[A][k], (int32_t)targets[A][k + 1]});
+    }
+    std::vector<int32_t> actionCheck, actionValue, gotoCheck, gotoValue;
+    std::vector<int32_t> actionBase = displaceRows(actionRows, T.columns, actionCheck, actionValue);
+    std::vector<int32_t> gotoBase = displaceRows(gotoRows, T.states, gotoCheck, gotoValue);
+    T.actionSize = actionCheck.size(), T.gotoSize = gotoCheck.size();
+    for (auto *part : {&actionBase, &actionDefault, &actionCheck, &actionValue, &gotoBase, &gotoDefault, &gotoCheck,
+                       &gotoValue})
+        T.store.insert(T.store.end(), part->begin(), part->end());
+
+    T.ruleStore.resize(2 * P);
+    for (uint32_t p = 0; p < P; p++)
+        T.ruleStore[p] = ntIndex[lhs[p]], T.ruleStore[P + p] = G.production(p).size();
+    T.point(T.store.data(), T.ruleStore.data());
+    return T;
+}
+
+// Shift-reduce recognition of `input`, in time linear in its length.
+// `stack` holds LR states (pass the same one to reuse its memory across
+// calls); `reductions`, if given, receives the productions reduced by, in
+// order, which is a rightmost derivation read backwards (see
+// rightmostDerivation).
+inline bool lalrRecognize(const LALRTables &T, const std::string &input, std::vector<uint32_t> &stack,
+                          std::vector<uint32_t> *reductions = nullptr)
+{
+    QueryStats stats("lalrRecognize", input.size());
+    stats.phase(Search);
+    stack.assign(1, 0);
+    size_t pos = 0, n = input.size();
+    while (true)
+    {
+        int32_t column = pos < n ? T.termColumn[(unsigned char)input[pos]] : (int32_t)T.endColumn;
+        if (column < 0)
+            return stats.result(false);
+        int32_t a = T.action(stack.back(), column);
+        stats.add(Steps);
+        if (a > 0)
+        {
+            stack.push_back(a - 1), pos++;
+            stats.peak(FrontierPeak, stack.size());
+        }
+        else if (a < 0)
+        {
+            uint32_t p = -a - 1;
+            if (p == T.productions)
+                return stats.result(true);
+            stack.resize(stack.size() - T.ruleLength[p]);
+            stack.push_back(T.go(stack.back(), T.ruleLhs[p]));
+            if (reductions)
+                reductions->push_back(p);
+        }
+        else
+            return stats.result(false);
+    }
+}
+
+// Left-hand side of production p, by a search over the rule ranges
+template <class AnyGrammar>
+Symbol productionLhs(const AnyGrammar &G, uint32_t p)
+{
+    Symbol A = 0;
+    while (!(G.firstRule(A) <= p && p < G.lastRule(A)))
+        A++;
+    return A;
+}
+
+// The sentential forms of the rightmost derivation that `reductions` (from
+// lalrRecognize) trace backwards, from the start symbol to the input
+template <class AnyGrammar>
+std::vector<std::string> rightmostDerivation(const AnyGrammar &G, const std::vector<uint32_t> &reductions)
+{
+    std::vector<Symbol> form = {G.start};
+    auto text = [&]() {
+        std::string s;
+        for (Symbol x : form)
+            s += G.name(x);
+        return s;
+    };
+    std::vector<std::string> steps = {text()};
+    for (auto it = reductions.rbegin(); it != reductions.rend(); ++it)
+    {
+        size_t i = form.size();
+        while (i-- > 0 && G.isTerminal(form[i]))
+            ;
+        Rhs r = G.production(*it);
+        form.erase(form.begin() + i);
+        form.insert(form.begin() + i, r.begin(), r.end());
+        steps.push_back(text());
+    }
+    return steps;
+}
+
+// One line per conflict: "state 3 on 'a': shift (kept) / reduce S → ab"
+template <class AnyGrammar>
+void printLALRConflicts(std::ostream &out, const AnyGrammar &G, const LALRTables &T)
+{
+    auto describe = [&](int32_t a) {
+        if (a > 0)
+            return std::string("shift");
+        uint32_t p = -a - 1;
+        std::string s = "reduce " + std::string(G.name(productionLhs(G, p))) + " → ";
+        for (Symbol x : G.production(p))
+            s += G.name(x);
+        return G.production(p).empty() ? s + "ε" : s;
+    };
+    for (const LALRConflict &c : T.conflicts)
+        out << "state " << c.state << " on "
+            << (c.terminal == LALRTables::endOfInput ? std::string("end of input") : "'" + std::string(G.name(c.terminal)) + "'")
+            << ": " << describe(c.kept) << " (kept) / " << describe(c.dropped) << "\n";
+}
+
+// Store deterministic LALR tables in an artifact next to their grammar
+inline void addLALRTables(ArtifactWriter &out, const LALRTables &T)
+{
+    uint64_t header[] = {T.states, T.columns, T.nonterminals, T.productions, T.endColumn, T.actionSize, T.gotoSize};
+    out.add(LALRHeader, header, 7);
+    out.add(LALRInts, T.termColumn, T.intCount());
+    out.add(LALRRules, T.ruleLhs, 2 * (size_t)T.productions);
+}
+
+// Point `T` at the LALR tables stored in `art`; false if they are missing or
+// their sizes disagree
+inline bool viewLALRTables(const Artifact &art, LALRTables &T)
+{
+    size_t headers, ints, rules;
+    const uint64_t *header = art.section<uint64_t>(LALRHeader, headers);
+    const int32_t *intData = art.section<int32_t>(LALRInts, ints);
+    const uint32_t *ruleData = art.section<uint32_t>(LALRRules, rules);
+    if (!header || headers != 7 || !intData || !ruleData)
+        return false;
+    T.states = header[0], T.columns = header[1], T.nonterminals = header[2], T.productions = header[3];
+    T.endColumn = header[4], T.actionSize = header[5], T.gotoSize = header[6];
+    T.store.clear(), T.ruleStore.clear(), T.conflicts.clear(), T.columnSymbols.clear();
+    if (ints != T.intCount() || rules != 2 * (size_t)T.productions || T.endColumn + 1 != T.columns)
+        return false;
+    T.point(intData, ruleData);
+    return true;
+}
@@ -2,6 +2,9 @@
 #include <map>
 #include <tuple>
 #include <string>
+#include "batch.h"
+#include "lba.h"
+#include "trace.h"
 using namespace std;
 
 // Transition table for the LBA Language: L = { a^n b^n | n >= 1 }
@@ -21,103 +24,111 @@ map<pair<string, char>, tuple<string, char, char>> transitions = {
     {{"q2", 'Y'}, {"q2", 'Y', 'L'}}, // Move left over Y’s while returning
 };
 
-// Simulate the Linear Bounded Automaton
-bool simulateLBA(string input)
+// The same table compiled to dense state ids, q0 start and q3 accept. The
+// machine falls off the left end once every a is marked, and accepts there if
+// every b is marked too, i.e. the tape holds only X and Y.
+const LBATable table = compileLBA(transitions, "q0", "q3", "XY");
+
+// Simulate the Linear Bounded Automaton with simulateLBA (lba.h)
+// With trace = false nothing is printed, only the verdict is returned.
+// Always halts: a repeated configuration gives Loops, and more than maxSteps
+// steps (0 = no limit) gives StepLimit. If `ring` is given, every step is
+// also recorded there as a binary trace event (see trace.h).
+LBAVerdict simulateLBA(string input, bool trace = true, size_t maxSteps = 0, TraceRing *ring = nullptr)
 {
-    string tape = input;    // Tape represents the string being processed
-    string state = "q0";    // Start in state q0
-    int head = 0;           // Tape head starts at the first symbol
-    string original = tape; // Keep the original string for output
+    string tape = input; // Follows the machine's tape, for printing and the ring
+    int head = 0;        // Where the head is after the last step
+    bool halted = false; // The last step read a symbol with no transition
+    if (ring)
+        ring->begin(&tape);
 
-    cout << "Initial tape: " << tape << "\n";
-
-    int step = 1;
-    while (true)
-    {
-        // Case 1: Head moves left past the beginning of the tape
-        // If this happens, check if the string is fully marked (only X and Y)
-        if (head < 0)
-        {
-            bool allMarked = true;
-            for (char c : tape)
-                if (c != 'X' && c != 'Y')
-                    allMarked = false;
-
-            if (allMarked)
-            {
-                // If all symbols are marked → accept
-                cout << "Final tape: " << tape << endl;
-                cout << "✅ Accepted: " << original << endl;
-                return true;
-            }
-            else
-            {
-                // If any unmarked a or b remains → reject
-                cout << "❌ Rejected (unmarked symbols left)\n";
-                return false;
-            }
-        }
-
-        // Case 2: Head moves past the end of the tape → reject
-        if (head >= (int)tape.size())
-        {
-            cout << "❌ Rejected (head out of bounds)\n";
-            return false;
-        }
-
-        // Read the current symbol under the head
-        char read = tape[head];
-        auto key = make_pair(state, read);
+    if (trace)
+        cout << "Initial tape: " << tape << "\n";
 
+    auto observe = [&](const LBAStep &s) {
         // Display current configuration
-        cout << "Step " << step++ << ": State=" << state
-             << ", Head=" << head
-             << ", Read='" << read << "', Tape=" << tape << endl;
-
-        // Case 3: No valid transition found
-        if (transitions.find(key) == transitions.end())
-        {
-            // If currently in accepting state (q3), accept
-            if (state == "q3")
-            {
-                cout << "Final tape: " << tape << endl;
-                cout << "✅ Accepted: " << original << endl;
-                return true;
-            }
-            // Otherwise, reject
-            cout << "❌ Rejected (no transition found)\n";
-            return false;
-        }
-
-        // Apply transition rule
-        auto [newState, write, move] = transitions[key];
-
-        // Replace the current symbol with the one specified in the transition
-        tape[head] = write;
-        // Update state
-        state = newState;
-
-        // Move tape head based on the transition direction:
-        // 'R' = right, 'L' = left, 'S' = stay
-        if (move == 'R')
-            head++;
-        else if (move == 'L')
-            head--;
-        else if (move == 'S')
-        {
-            // If machine stays and is in accept state, accept the string
-            if (state == "q3")
-            {
-                cout << "Final tape: " << tape << endl;
-                cout << "✅ Accepted: " << original << endl;
-                return true;
-            }
-        }
+        if (trace)
+            cout << "Step " << s.step << ": State=" << table.names[s.state]
+                 << ", Head=" << s.head
+                 << ", Read='" << s.read << "', Tape=" << tape << "\n";
+        if (ring && s.entry)
+            ring->record(s.step, s.state, s.head, s.read, LBATable::written(s.entry), LBATable::move(s.entry), s.run);
+        else if (ring)
+            ring->record(s.step, s.state, s.head, s.read, s.read, NoMove, 0); // Halts here
+
+        // Replace the current symbol and move the head; a sweep leaves the
+        // tape unchanged and moves it by the length of the run
+        halted = !s.entry;
+        if (halted)
+            return;
+        tape[s.head] = LBATable::written(s.entry);
+        LBAMove move = LBATable::move(s.entry);
+        head = move == MoveRight ? s.head + (int)s.run : move == MoveLeft ? s.head - (int)s.run : s.head;
+    };
+    // Without a printed trace, skip runs of sweep self-loops in one go
+    LBAVerdict verdict = simulateLBA(table, input, maxSteps, nullptr, observe, !trace);
+
+    if (!trace)
+        return verdict;
+    if (verdict == Accepts)
+    {
+        cout << "Final tape: " << tape << endl;
+        cout << "✅ Accepted: " << input << endl;
     }
+    else if (verdict == Loops)
+        cout << "❌ Rejected (machine loops forever)\n";
+    else if (verdict == StepLimit)
+        cout << "❌ Rejected (step limit reached)\n";
+    else if (halted)
+        cout << "❌ Rejected (no transition found)\n";
+    else if (head < 0)
+        cout << "❌ Rejected (unmarked symbols left)\n";
+    else
+        cout << "❌ Rejected (head out of bounds)\n";
+    return verdict;
 }
 
-int main()
+int main(int argc, char *argv[])
 {
+    // --max-steps N: give up after N steps (default: no limit; looping
+    // machines are still stopped by cycle detection)
+    size_t maxSteps = flagValue(argc, argv, "--max-steps", 0);
+
+    // --stats FILE: one JSON line of run counters per input (see stats.h)
+    if (!openStats(argc, argv))
+        return 1;
+
+    // --trace-file PATH [--trace-level full|sampled|off] [--trace-every K]:
+    // record a binary trace (trace.h) instead of printing every step, and
+    // save it to PATH for tracedump. Sampled traces keep every K-th step;
+    // --trace-capacity N sets how many events the ring retains.
+    string traceFile, traceLevel = "full";
+    for (int i = 1; i + 1 < argc; i++)
+        if (string(argv[i]) == "--trace-file")
+            traceFile = argv[i + 1];
+        else if (string(argv[i]) == "--trace-level")
+            traceLevel = argv[i + 1];
+    TraceRing ring(traceFile.empty() || traceLevel == "off" ? TraceLevel::Off
+                   : traceLevel == "sampled"                ? TraceLevel::Sampled
+                                                            : TraceLevel::Full,
+                   flagValue(argc, argv, "--trace-every", 1000), flagValue(argc, argv, "--trace-capacity", 1 << 16));
+
+    // --batch [file] [--threads N]: decide every line of the file (or stdin), no traces.
+    // With --trace-file, each worker traces into its own ring and saves the
+    // trace of any input that loops or hits the step limit to PATH.<hash>.
+    string batchPath;
+    if (batchRequested(argc, argv, batchPath))
+        return runBatch(batchPath, [&, ring](const string &s) mutable {
+            LBAVerdict verdict = simulateLBA(s, false, maxSteps, ring.enabled() ? &ring : nullptr);
+            if (ring.enabled() && (verdict == Loops || verdict == StepLimit))
+            {
+                char suffix[32];
+                snprintf(suffix, sizeof suffix, ".%016zx", hash<string>()(s));
+                ring.save(traceFile + suffix, table.names);
+            }
+            return verdict;
+        }, batchThreads(argc, argv));
+
     string input;
     cout << "\nLinear Bounded Automata Simulation\n";
     cout << "Language: L = { a^n b^n | n >= 1 }\n";
@@ -125,6 +136,17 @@ int main()
     cin >> input;
 
     // Run the LBA simulation
-    simulateLBA(input);
+    if (!ring.enabled())
+    {
+        simulateLBA(input, true, maxSteps);
+        return 0;
+    }
+    LBAVerdict verdict = simulateLBA(input, false, maxSteps, &ring);
+    cout << (verdict == Accepts ? "✅ Accepted: " : "❌ Rejected: ") << input << endl;
+    if (!ring.save(traceFile, table.names))
+    {
+        cerr << "Cannot write " << traceFile << "\n";
+        return 1;
+    }
     return 0;
 }
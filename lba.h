@@ -0,0 +1,416 @@
+#pragma once
+// Linear bounded automata compiled for simulation. Transition maps are written
+// as readable tables keyed by (state name, symbol read); compileLBA numbers the
+// states densely and flattens the map into one [state][256] array of packed
+// transitions, so a simulation step is a single indexed load.
+//
+// Compilation also finds sweeps: self-loops that leave the symbol unchanged
+// and keep moving the same way (q1 over a/Y moving right, q2 over X/Y moving
+// left). A run of those is one macro-step at runtime: the head jumps to the
+// first symbol outside the sweep set, found a word at a time, and the step
+// count advances by the distance travelled.
+//
+// An LBA has finitely many configurations (state, head, tape), so a run that
+// revisits one never halts. LBACycleDetector spots that with Brent's
+// algorithm over an incrementally updated configuration hash, letting a
+// simulator report "loops" instead of spinning forever.
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "stats.h"
+
+// (state, symbol read) -> (new state, symbol to write, head move 'L'/'R'/'S')
+using LBATransitions = std::map<std::pair<std::string, char>, std::tuple<std::string, char, char>>;
+
+// Packed transition: bits 0-7 the symbol to write, bits 8-9 the move, bits
+// 10-31 the next state. Move 0 never occurs in a real entry, so 0 means "no
+// transition".
+enum LBAMove : uint32_t { NoMove = 0, MoveRight = 1, MoveLeft = 2, Stay = 3 };
+
+// Outcome of a simulation. The codes double as batch verdict codes (batch.h).
+enum LBAVerdict : char { Rejects = 0, Accepts = 1, Loops = 2, StepLimit = 3 };
+
+// Symbols a state sweeps over in one direction
+struct SweepSet
+{
+    static constexpr uint64_t ones = 0x0101010101010101ULL, highs = 0x8080808080808080ULL;
+    static constexpr bool wordScan = __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+
+    int count = 0;               // Distinct symbols; 0 means no sweep
+    unsigned char symbols[4];    // The symbols, while there are at most 4
+    bool member[256] = {};
+
+    void add(unsigned char c)
+    {
+        if (count < 4)
+            symbols[count] = c;
+        member[c] = true;
+        count++;
+    }
+
+    // High bit set in every byte of x that is in the set (exact, no carries
+    // between bytes)
+    uint64_t matchWord(uint64_t x) const
+    {
+        uint64_t in = 0;
+        for (int k = 0; k < count; k++)
+        {
+            uint64_t t = x ^ (symbols[k] * ones);
+            in |= ~(((t & ~highs) + ~highs) | t) & highs;
+        }
+        return in;
+    }
+
+    // First position >= i whose symbol is not in the set, or size
+    int scanRight(const char *tape, int i, int size) const
+    {
+        if (wordScan && count <= 4)
+            for (uint64_t x; i + 8 <= size; i += 8)
+            {
+                std::memcpy(&x, tape + i, 8);
+                if (uint64_t out = ~matchWord(x) & highs)
+                    return i + __builtin_ctzll(out) / 8;
+            }
+        while (i < size && member[(unsigned char)tape[i]])
+            i++;
+        return i;
+    }
+
+    // Last position <= i whose symbol is not in the set, or -1
+    int scanLeft(const char *tape, int i) const
+    {
+        if (wordScan && count <= 4)
+            for (uint64_t x; i >= 7; i -= 8)
+            {
+                std::memcpy(&x, tape + i - 7, 8);
+                if (uint64_t out = ~matchWord(x) & highs)
+                    return i - 7 + (63 - __builtin_clzll(out)) / 8;
+            }
+        while (i >= 0 && member[(unsigned char)tape[i]])
+            i--;
+        return i;
+    }
+};
+
+struct LBATable
+{
+    std::vector<std::string> names;             // Dense state id -> name
+    std::unordered_map<std::string, int> ids;   // Name -> dense state id
+    std::vector<uint32_t> next;                 // [state * 256 + symbol]
+    std::vector<SweepSet> sweepRight, sweepLeft; // Per state
+    uint32_t start = 0, accept = 0;
+    std::string marked; // Falling off the left end of a tape of only these symbols also accepts
+
+    static uint32_t pack(uint32_t state, unsigned char write, LBAMove move)
+    {
+        return state << 10 | (uint32_t)move << 8 | write;
+    }
+    static uint32_t target(uint32_t e) { return e >> 10; }
+    static unsigned char written(uint32_t e) { return e & 0xFF; }
+    static LBAMove move(uint32_t e) { return (LBAMove)(e >> 8 & 3); }
+
+    uint32_t at(uint32_t state, char read) const { return next[state << 8 | (unsigned char)read]; }
+
+    // Verdict for a head that left the tape on the left
+    bool acceptsAtLeftEnd(uint32_t state, const std::string &tape) const
+    {
+        return state == accept || (!marked.empty() && tape.find_first_not_of(marked) == std::string::npos);
+    }
+
+    // Macro-step: if the symbol under the head starts a sweep of `state`, move
+    // the head past the whole run and return the number of single steps that
+    // took; otherwise return 0. The state and tape are unchanged by a sweep.
+    size_t sweep(uint32_t state, const char *tape, int size, int &head) const
+    {
+        unsigned char c = tape[head];
+        int from = head;
+        if (sweepRight[state].member[c])
+            return (head = sweepRight[state].scanRight(tape, head, size)) - from;
+        if (sweepLeft[state].member[c])
+            return from - (head = sweepLeft[state].scanLeft(tape, head));
+        return 0;
+    }
+};
+
+// SplitMix64 finalizer: scrambles a key into a well-spread 64-bit hash
+inline uint64_t mix64(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// Brent's cycle detection over the configurations a simulator passes
+// through. The tape part of the hash is a XOR of per-cell keys, so a write
+// updates it in O(1). The configuration saved at each power-of-two checkpoint
+// is kept in full and compared exactly on a hash match, so a reported cycle
+// is never a collision. Hashing the tape costs O(n), so tracking only starts
+// after a warm-up of as many steps; short runs never pay for it, and a loop
+// is still caught once it is under way.
+struct LBACycleDetector
+{
+    size_t warmup = 0; // Steps left before tracking starts
+    bool armed = false;
+    uint64_t tapeHash = 0;
+    uint64_t savedHash = 0;
+    uint32_t savedState = 0;
+    int savedHead = 0;
+    std::string savedTape;
+    size_t power = 1, lambda = 0; // Checkpoint interval, steps since the checkpoint
+
+    static uint64_t cell(int pos, unsigned char c) { return mix64((uint64_t)pos << 8 | c); }
+    uint64_t hash(uint32_t state, int head) const
+    {
+        return tapeHash ^ mix64((uint64_t)state << 32 | (uint32_t)head | 1ULL << 63);
+    }
+
+    // Start tracking after `delay` steps; the tape length is a good delay
+    void start(size_t delay)
+    {
+        warmup = delay, armed = false;
+    }
+
+    // Call for every write, before or after it happens
+    void write(int pos, unsigned char from, unsigned char to)
+    {
+        if (armed && from != to)
+            tapeHash ^= cell(pos, from) ^ cell(pos, to);
+    }
+
+    // Call after every (macro-)step: true if this configuration was seen
+    // before, i.e. the machine loops forever
+    bool looped(uint32_t state, int head, const std::string &tape)
+    {
+        if (!armed)
+        {
+            if (warmup > 0)
+            {
+                warmup--;
+                return false;
+            }
+            // Take this configuration as the first checkpoint
+            tapeHash = 0;
+            for (size_t i = 0; i < tape.size(); i++)
+                tapeHash ^= cell(i, tape[i]);
+            armed = true, power = 1, lambda = 0;
+            savedHash = hash(state, head), savedState = state, savedHead = head, savedTape = tape;
+            return false;
+        }
+        uint64_t h = hash(state, head);
+        if (h == savedHash && state == savedState && head == savedHead && tape == savedTape)
+            return true;
+        if (++lambda == power)
+        {
+            power *= 2, lambda = 0;
+            savedHash = h, savedState = state, savedHead = head, savedTape = tape;
+        }
+        return false;
+    }
+};
+
+inline LBATable compileLBA(const LBATransitions &transitions, const std::string &start, const std::string &accept,
+                           const std::string &marked = "")
+{
+    LBATable T;
+    T.marked = marked;
+    auto id = [&](const std::string &name) {
+        auto [it, fresh] = T.ids.try_emplace(name, (int)T.names.size());
+        if (fresh)
+            T.names.push_back(name);
+        return (uint32_t)it->second;
+    };
+    T.start = id(start);
+    T.accept = id(accept);
+    for (auto &[key, value] : transitions)
+    {
+        id(key.first);
+        id(std::get<0>(value));
+    }
+
+    T.next.assign(T.names.size() * 256, 0);
+    for (auto &[key, value] : transitions)
+    {
+        auto &[newState, write, dir] = value;
+        LBAMove move = dir == 'R' ? MoveRight : dir == 'L' ? MoveLeft : Stay;
+        T.next[id(key.first) << 8 | (unsigned char)key.second] = LBATable::pack(id(newState), write, move);
+    }
+
+    // Sweeps: self-loops that rewrite the symbol unchanged and move the head
+    T.sweepRight.assign(T.names.size(), {});
+    T.sweepLeft.assign(T.names.size(), {});
+    for (uint32_t q = 0; q < T.names.size(); q++)
+        for (int c = 0; c < 256; c++)
+        {
+            uint32_t e = T.next[q << 8 | c];
+            if (!e || LBATable::target(e) != q || LBATable::written(e) != c)
+                continue;
+            if (LBATable::move(e) == MoveRight)
+                T.sweepRight[q].add(c);
+            else if (LBATable::move(e) == MoveLeft)
+                T.sweepLeft[q].add(c);
+        }
+    return T;
+}
+
+// Text form of a machine, one transition per line after the start and accept
+// states; '#' starts a comment and symbols are single characters:
+//   start q0
+//   accept q3
+//   q0 a -> q1 X R
+inline void printLBA(std::ostream &out, const LBATransitions &transitions, const std::string &start,
+                     const std::string &accept)
+{
+    out << "start " << start << "\naccept " << accept << "\n";
+    for (auto &[key, value] : transitions)
+        out << key.first << " " << key.second << " -> " << std::get<0>(value) << " " << std::get<1>(value) << " "
+            << std::get<2>(value) << "\n";
+}
+
+// Read the printLBA form. On a syntax error or a second transition for the
+// same (state, symbol), returns false with `error` naming the line.
+inline bool readLBA(std::istream &in, LBATransitions &transitions, std::string &start, std::string &accept,
+                    std::string &error)
+{
+    transitions.clear();
+    start.clear(), accept.clear();
+    std::string line;
+    for (int number = 1; std::getline(in, line); number++)
+    {
+        std::istringstream words(line.substr(0, line.find('#')));
+        std::string state, read, arrow, next, write, move, rest;
+        if (!(words >> state))
+            continue;
+        auto fail = [&](const std::string &why) {
+            error = "line " + std::to_string(number) + ": " + why;
+            return false;
+        };
+        if (state == "start" || state == "accept")
+        {
+            if (!(words >> (state == "start" ? start : accept)) || words >> rest)
+                return fail("expected " + state + " STATE");
+            continue;
+        }
+        if (!(words >> read >> arrow >> next >> write >> move) || words >> rest || arrow != "->" ||
+            read.size() != 1 || write.size() != 1 || move.size() != 1 || move.find_first_of("LRS") != 0)
+            return fail("expected STATE SYMBOL -> STATE SYMBOL L|R|S");
+        if (!transitions.emplace(std::make_pair(state, read[0]), std::make_tuple(next, write[0], move[0])).second)
+            return fail("a second transition for (" + state + ", " + read + ")");
+    }
+    if (start.empty() || accept.empty())
+    {
+        error = "the start or accept state is missing";
+        return false;
+    }
+    return true;
+}
+
+// One step of simulateLBA as its observer sees it, before the step changes
+// the tape: the configuration and the entry applied (0 if none applies and
+// the machine halts here, with run = 0). A sweep is one event whose run is
+// the number of single steps it took.
+struct LBAStep
+{
+    size_t step;    // Number of the (first) step, from 1
+    uint32_t state;
+    int head;
+    char read;
+    uint32_t entry; // Packed transition, see LBATable
+    size_t run;     // Single steps taken: 1, more for a sweep, 0 when halting
+};
+
+// Simulate any LBA given its compiled transition table (start and accept
+// states included, see compileLBA) and input. Runs of sweep self-loops are
+// taken as macro-steps unless `sweeps` is false; `steps`, if given, still
+// receives the exact number of single steps, and observe(const LBAStep &) is
+// called before each one (e.g. to print or record a trace). Always halts: a
+// repeated configuration gives Loops, and more than maxSteps steps (0 = no
+// limit) gives StepLimit. Reading a symbol with no transition is not a step.
+template <class Observer>
+inline LBAVerdict simulateLBA(const LBATable &T, std::string input, size_t maxSteps, size_t *steps, Observer &&observe,
+                              bool sweeps = true)
+{
+    QueryStats stats("simulateLBA", input.size());
+    std::string tape = input; // Tape of symbols
+    uint32_t state = T.start;
+    int head = 0;             // Head starts at the beginning of tape
+    int size = tape.size();
+    size_t count;
+    if (!steps)
+        steps = &count;
+    *steps = 0;
+    if (!maxSteps)
+        maxSteps = SIZE_MAX - 1;
+    LBACycleDetector cycle;
+    cycle.start(size);
+    stats.phase(Search);
+
+    while (true)
+    {
+        // Head moved past left → check acceptance
+        if (head < 0)
+            return stats.result(T.acceptsAtLeftEnd(state, tape) ? Accepts : Rejects);
+
+        // Head moved past right → reject
+        if (head >= size)
+            return stats.result(Rejects);
+
+        // Skip a run of sweep self-loops in one go
+        int from = head;
+        if (size_t run = sweeps ? T.sweep(state, tape.data(), size, head) : 0)
+        {
+            // Stop the sweep where the budget runs out, so the step limit is
+            // still reached one step past maxSteps
+            if (*steps + run > maxSteps + 1)
+            {
+                run = maxSteps + 1 - *steps;
+                head = head > from ? from + (int)run : from - (int)run;
+            }
+            observe(LBAStep{*steps + 1, state, from, tape[from], T.at(state, tape[from]), run});
+            *steps += run;
+            stats.add(Steps, run);
+            stats.add(MacroSteps);
+            stats.sample(SweepLength, run);
+        }
+        else
+        {
+            // No valid transition → accept if in accept state, else reject
+            uint32_t e = T.at(state, tape[head]);
+            observe(LBAStep{*steps + 1, state, head, tape[head], e, e ? 1u : 0u});
+            if (!e)
+                return stats.result(state == T.accept ? Accepts : Rejects);
+
+            // Apply the transition
+            ++*steps;
+            stats.add(Steps);
+            cycle.write(head, tape[head], LBATable::written(e));
+            tape[head] = LBATable::written(e); // Write the symbol
+            state = LBATable::target(e);       // Update state
+
+            // Move head
+            LBAMove move = LBATable::move(e);
+            if (move == MoveRight) head++;
+            else if (move == MoveLeft) head--;
+            else if (state == T.accept)
+                return stats.result(Accepts); // Accept if staying in accept state
+        }
+
+        if (*steps > maxSteps)
+            return stats.result(StepLimit);
+        if (cycle.looped(state, head, tape))
+            return stats.result(Loops);
+    }
+}
+
+inline LBAVerdict simulateLBA(const LBATable &T, std::string input, size_t maxSteps = 0, size_t *steps = nullptr)
+{
+    return simulateLBA(T, std::move(input), maxSteps, steps, [](const LBAStep &) {});
+}
@@ -1,7 +1,11 @@
 #include <iostream>
+#include <fstream>
 #include <map>
 #include <tuple>
 #include <string>
+#include "batch.h"
+#include "lba.h"
+#include "nlba.h"
 using namespace std;
 
 // Transition table representation:
@@ -10,46 +14,6 @@ using namespace std;
 using Transition = tuple<string, char, char>; // new_state, write_symbol, move_dir
 using StateSymbol = pair<string, char>;       // current_state, read_symbol
 
-// Simulate any LBA given a transition table, start state, accept states, and input
-bool simulateLBA(const map<StateSymbol, Transition> &transitions,
-                 const string &startState,
-                 const string &acceptState,
-                 string input)
-{
-    string tape = input;  // Tape of symbols
-    string state = startState;
-    int head = 0;         // Head starts at the beginning of tape
-
-    while (true)
-    {
-        // Head moved past left → check acceptance
-        if (head < 0)
-            return state == acceptState;
-
-        // Head moved past right → reject
-        if (head >= (int)tape.size())
-            return false;
-
-        char read = tape[head];
-        auto key = make_pair(state, read);
-
-        // No valid transition → accept if in accept state, else reject
-        if (transitions.find(key) == transitions.end())
-            return state == acceptState;
-
-        // Apply the transition
-        auto [newState, write, move] = transitions.at(key);
-        tape[head] = write;  // Write the symbol
-        state = newState;    // Update state
-
-        // Move head
-        if (move == 'R') head++;
-        else if (move == 'L') head--;
-        else if (move == 'S' && state == acceptState)
-            return true; // Accept if staying in accept state
-    }
-}
-
 // Example LBA: L = { a^n b^n | n >= 1 }
 map<StateSymbol, Transition> exampleTransitions = {
     {{"q0", 'a'}, {"q1", 'X', 'R'}},
@@ -65,20 +29,84 @@ map<StateSymbol, Transition> exampleTransitions = {
     {{"q2", 'Y'}, {"q2", 'Y', 'L'}},
 };
 
+// Example nondeterministic LBA: L = { w in {a, b}* | w contains "aba" }.
+// At every 'a', q0 either keeps scanning or guesses that "aba" starts here.
+NLBATransitions nondeterministicExample = {
+    {{"q0", 'a'}, {"q0", 'a', 'R'}},
+    {{"q0", 'a'}, {"q1", 'a', 'R'}},
+    {{"q0", 'b'}, {"q0", 'b', 'R'}},
+
+    {{"q1", 'b'}, {"q2", 'b', 'R'}},
+
+    {{"q2", 'a'}, {"q3", 'a', 'S'}},
+};
+
 // Main
-int main()
+int main(int argc, char *argv[])
 {
+    // --machine FILE: simulate the machine in FILE (printLBA format, e.g.
+    // from gen lba) instead of the deterministic example
+    string machinePath = flagText(argc, argv, "--machine"), start = "q0", accept = "q3", error;
+    LBATransitions transitions = exampleTransitions;
+    if (!machinePath.empty())
+    {
+        ifstream file(machinePath);
+        if (!file || !readLBA(file, transitions, start, accept, error))
+        {
+            cerr << machinePath << ": " << (file ? error : "cannot open") << endl;
+            return 1;
+        }
+    }
+
+    // Compile the transition map once
+    LBATable table = compileLBA(transitions, start, accept);
+
+    // --max-steps N: give up after N steps (default: no limit; looping
+    // machines are still stopped by cycle detection). For the
+    // nondeterministic example it bounds the configurations explored.
+    size_t maxSteps = flagValue(argc, argv, "--max-steps", 0);
+
+    // --stats FILE: one JSON line of run or search counters per input (see stats.h)
+    if (!openStats(argc, argv))
+        return 1;
+
+    // --nondeterministic: run the nondeterministic example instead
+    bool nondeterministic = hasFlag(argc, argv, "--nondeterministic");
+    NLBATable ntable = compileNLBA(nondeterministicExample, "q0", "q3");
+
+    // --batch [file] [--threads N]: decide every line of the file (or stdin)
+    string batchPath;
+    if (batchRequested(argc, argv, batchPath))
+    {
+        if (nondeterministic)
+            return runBatch(batchPath, [&](const string &s) { return exploreNLBA(ntable, s, 1, maxSteps); },
+                            batchThreads(argc, argv));
+        return runBatch(batchPath, [&](const string &s) { return simulateLBA(table, s, maxSteps); },
+                        batchThreads(argc, argv));
+    }
+
     cout << "\nGeneric LBA Simulator\n";
-    cout << "Example: Language L = { a^n b^n | n >= 1 }\n";
+    if (nondeterministic)
+        cout << "Example: Language L = { w in {a, b}* | w contains \"aba\" } (nondeterministic)\n";
+    else if (!machinePath.empty())
+        cout << "Machine: " << machinePath << " (" << table.names.size() << " states)\n";
+    else
+        cout << "Example: Language L = { a^n b^n | n >= 1 }\n";
 
     string input;
     cout << "Enter input string: ";
     cin >> input;
 
-    // Run the LBA simulation
-    bool accepted = simulateLBA(exampleTransitions, "q0", "q3", input);
+    // Run the LBA simulation (a single input gets all threads)
+    LBAVerdict verdict = nondeterministic ? exploreNLBA(ntable, input, batchThreads(argc, argv), maxSteps)
+                                          : simulateLBA(table, input, maxSteps);
 
-    cout << (accepted ? "✅ Accepted" : "❌ Rejected") << endl;
+    if (verdict == Loops)
+        cout << "❌ Rejected (machine loops forever)" << endl;
+    else if (verdict == StepLimit)
+        cout << "❌ Rejected (step limit reached)" << endl;
+    else
+        cout << (verdict == Accepts ? "✅ Accepted" : "❌ Rejected") << endl;
 
     return 0;
 }
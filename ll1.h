@@ -0,0 +1,267 @@
+#pragma once
+// LL(1) analysis and predictive parsing for the char-keyed grammars of
+// cfg-pda.cpp (unordered_map<char, vector<string>>, a key is a nonterminal,
+// 'S' starts, "" is ε). When one symbol of lookahead decides every
+// expansion, the PDA of the grammar is deterministic and needs no search:
+// the parse table says which rule to expand, and a run is linear in the input.
+//
+// compileLL1 computes nullable/FIRST/FOLLOW by iterating to a fixed point,
+// then fills a dense table indexed by (nonterminal, lookahead), where the
+// lookahead is a byte or the end of the input. A cell claimed by two rules is
+// a conflict; it keeps the first rule and is listed in `conflicts`, so a
+// grammar is LL(1) exactly when that list is empty.
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "stats.h"
+
+// Lookahead 256 is the end of the input
+constexpr int endOfInput = 256;
+using Lookaheads = std::bitset<257>;
+
+// Two rules of one nonterminal that both claim a lookahead
+struct LL1Conflict
+{
+    char nonterminal;
+    int lookahead;     // Byte, or endOfInput
+    int first, second; // Rule ids (see LL1Table::ruleText)
+    bool followSide;   // FIRST/FOLLOW: one of the rules derives ε and the lookahead follows
+};
+
+// Stack symbols are uint16: a byte is a terminal, 256 + k is nonterminal k
+struct LL1Table
+{
+    std::vector<char> names;                    // Dense nonterminal id -> name
+    int16_t ids[256];                           // Char -> nonterminal id, -1 for a terminal
+    std::vector<uint32_t> rhsBegin{0};          // Per rule, plus one
+    std::vector<uint16_t> rhs;                  // Right-hand sides, each stored reversed for pushing
+    std::vector<int> lhs;                       // Per rule
+    std::vector<int32_t> table;                 // [nonterminal * 257 + lookahead] -> rule, -1 if none
+    std::vector<uint8_t> nullable;              // Per nonterminal
+    std::vector<Lookaheads> first, follow;      // Per nonterminal; FIRST never holds endOfInput
+    std::vector<LL1Conflict> conflicts;
+    int start = -1;                             // Id of S, -1 if S has no rules
+
+    bool isLL1() const { return conflicts.empty(); }
+    int rule(int A, int lookahead) const { return table[A * 257 + lookahead]; }
+    // Rule r as text, e.g. "S → aSb"
+    std::string ruleText(int r) const
+    {
+        std::string text = std::string(1, names[lhs[r]]) + " → ";
+        if (rhsBegin[r] == rhsBegin[r + 1])
+            return text + "ε";
+        for (uint32_t i = rhsBegin[r + 1]; i-- > rhsBegin[r];)
+            text += rhs[i] < 256 ? (char)rhs[i] : names[rhs[i] - 256];
+        return text;
+    }
+};
+
+inline LL1Table compileLL1(const std::unordered_map<char, std::vector<std::string>> &grammar)
+{
+    LL1Table T;
+    std::fill(std::begin(T.ids), std::end(T.ids), -1);
+    for (auto &[A, _] : grammar)
+    {
+        T.ids[(unsigned char)A] = T.names.size();
+        T.names.push_back(A);
+    }
+    size_t N = T.names.size();
+    for (auto &[A, prods] : grammar)
+        for (const std::string &prod : prods)
+        {
+            for (size_t i = prod.size(); i-- > 0;)
+            {
+                unsigned char c = prod[i];
+                T.rhs.push_back(T.ids[c] < 0 ? c : 256 + T.ids[c]);
+            }
+            T.rhsBegin.push_back(T.rhs.size());
+            T.lhs.push_back(T.ids[(unsigned char)A]);
+        }
+    size_t R = T.lhs.size();
+    if (T.ids[(unsigned char)'S'] >= 0)
+        T.start = T.ids[(unsigned char)'S'];
+
+    // FIRST of the symbols rhs[from .. to) read backwards (the stored order
+    // is reversed), and whether they all derive ε
+    auto firstOf = [&](uint32_t from, uint32_t to, Lookaheads &out) {
+        for (uint32_t i = to; i-- > from;)
+        {
+            uint16_t s = T.rhs[i];
+            if (s < 256)
+            {
+                out.set(s);
+                return false;
+            }
+            out |= T.first[s - 256];
+            if (!T.nullable[s - 256])
+                return false;
+        }
+        return true;
+    };
+
+    T.nullable.assign(N, 0);
+    T.first.assign(N, Lookaheads());
+    for (bool changed = true; changed;)
+    {
+        changed = false;
+        for (size_t r = 0; r < R; r++)
+        {
+            int A = T.lhs[r];
+            Lookaheads before = T.first[A];
+            if (firstOf(T.rhsBegin[r], T.rhsBegin[r + 1], T.first[A]) && !T.nullable[A])
+                T.nullable[A] = 1, changed = true;
+            changed |= T.first[A] != before;
+        }
+    }
+
+    // FOLLOW: what comes after each occurrence, and FOLLOW of the left-hand
+    // side when the rest of the rule derives ε
+    T.follow.assign(N, Lookaheads());
+    if (T.start >= 0)
+        T.follow[T.start].set(endOfInput);
+    for (bool changed = true; changed;)
+    {
+        changed = false;
+        for (size_t r = 0; r < R; r++)
+            for (uint32_t i = T.rhsBegin[r]; i < T.rhsBegin[r + 1]; i++)
+                if (uint16_t s = T.rhs[i]; s >= 256)
+                {
+                    // The symbols after it are rhs[rhsBegin[r] .. i) in the reversed order
+                    Lookaheads &follow = T.follow[s - 256];
+                    Lookaheads before = follow;
+                    if (firstOf(T.rhsBegin[r], i, follow))
+                        follow |= T.follow[T.lhs[r]];
+                    changed |= follow != before;
+                }
+    }
+
+    // The table: rule r of A goes under FIRST(rhs), and under FOLLOW(A) if rhs derives ε
+    T.table.assign(N * 257, -1);
+    for (size_t r = 0; r < R; r++)
+    {
+        int A = T.lhs[r];
+        Lookaheads claims;
+        bool empty = firstOf(T.rhsBegin[r], T.rhsBegin[r + 1], claims);
+        Lookaheads fromFirst = claims;
+        if (empty)
+            claims |= T.follow[A];
+        for (int a = 0; a < 257; a++)
+        {
+            if (!claims[a])
+                continue;
+            int32_t &cell = T.table[A * 257 + a];
+            if (cell < 0)
+                cell = r;
+            else
+            {
+                // FIRST/FIRST if both right-hand sides start with it
+                Lookaheads other;
+                firstOf(T.rhsBegin[cell], T.rhsBegin[cell + 1], other);
+                T.conflicts.push_back({T.names[A], a, cell, (int)r, !(fromFirst[a] && other[a])});
+            }
+        }
+    }
+
+    return T;
+}
+
+// One line per conflict: "S on 'a': S → aSb | S → ab (FIRST/FIRST)"
+inline void printLL1Conflicts(std::ostream &out, const LL1Table &T)
+{
+    for (const LL1Conflict &c : T.conflicts)
+        out << c.nonterminal << " on "
+            << (c.lookahead == endOfInput ? std::string("end of input") : "'" + std::string(1, (char)c.lookahead) + "'")
+            << ": " << T.ruleText(c.first) << " | " << T.ruleText(c.second)
+            << (c.followSide ? " (FIRST/FOLLOW)\n" : " (FIRST/FIRST)\n");
+}
+
+// Predictive parse of `input` with the table of an LL(1) grammar. The stack
+// grows on demand and keeps its memory across calls (pass the same `stack`),
+// so once it is warm a step is a table load and a copy of the reversed
+// right-hand side, with no allocation; on an LL(1) table only an empty cell
+// or a mismatched terminal rejects. On a table with conflicts the first rule
+// of each cell is used, which can expand forever without reading input
+// (S → S | a keeps S → S). Such a run has some nonterminal on top at a
+// height it was already expanded at, with the stack below untouched since,
+// and from there would repeat itself; the parser keeps a record per
+// expansion since the last input symbol to catch that and rejects. With
+// trace = true the stack after every step is printed, in the format
+// simulateCFGtoPDA uses.
+inline bool ll1Parse(const LL1Table &T, const std::string &input, std::vector<uint16_t> &stack, bool trace = false)
+{
+    QueryStats stats("ll1Parse", input.size());
+    if (T.start < 0)
+        return stats.result(false);
+    if (stack.empty())
+        stack.resize(64);
+    uint16_t *base = stack.data();
+    size_t top = 0, pos = 0, n = input.size();
+    base[top++] = 256 + T.start;
+
+    // Expansions since the last input symbol whose stack below is untouched
+    // since: (height, nonterminal), heights nondecreasing. Only kept for a
+    // table with conflicts; an LL(1) table cannot loop.
+    bool guard = !T.isLL1();
+    std::vector<std::pair<size_t, int>> expanded;
+    std::vector<uint8_t> pending(guard ? T.names.size() : 0, 0);
+
+    std::string path;
+    auto show = [&]() {
+        path += path.empty() ? "[" : " -> [";
+        for (size_t i = 0; i < top; i++)
+            path += base[i] < 256 ? (char)base[i] : T.names[base[i] - 256];
+        path += "]";
+    };
+    if (trace)
+        show();
+
+    stats.phase(Search);
+    bool stuck = false;
+    while (top > 0 && !stuck)
+    {
+        uint16_t s = base[--top];
+        int lookahead = pos < n ? (unsigned char)input[pos] : endOfInput;
+        // Popping height `top` touches the stack below every record above it
+        while (guard && !expanded.empty() && expanded.back().first > top)
+            pending[expanded.back().second] = 0, expanded.pop_back();
+        if (s < 256)
+        {
+            stuck = s != lookahead;
+            pos += !stuck;
+            for (; !expanded.empty(); expanded.pop_back())
+                pending[expanded.back().second] = 0;
+        }
+        else
+        {
+            int A = s - 256, r = T.rule(A, lookahead);
+            if (r < 0 || (guard && pending[A]))
+            {
+                stuck = true;
+                break;
+            }
+            if (guard)
+                pending[A] = 1, expanded.push_back({top, A});
+            uint32_t from = T.rhsBegin[r], length = T.rhsBegin[r + 1] - from;
+            if (top + length > stack.size())
+            {
+                stack.resize(std::max(2 * stack.size(), top + length));
+                base = stack.data();
+            }
+            std::copy_n(&T.rhs[from], length, base + top);
+            top += length;
+            stats.add(Expanded);
+            stats.peak(FrontierPeak, top);
+        }
+        if (trace)
+            show();
+    }
+
+    bool accepted = !stuck && pos == n;
+    if (trace)
+        std::cout << (accepted ? "\nString accepted!\nTransitions:\n" + path + "\n" : std::string("\nString rejected!\n"));
+    return stats.result(accepted);
+}
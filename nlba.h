@@ -0,0 +1,347 @@
+#pragma once
+// Nondeterministic linear bounded automata. The transition table is a
+// multimap, so one (state, symbol) key may have several moves; the machine
+// accepts if any branch does, with the same halting rules as simulateLBA in
+// lba2.cpp (falling off the left end or getting stuck accepts in the accept
+// state, falling off the right end rejects, a stay move into the accept state
+// accepts).
+//
+// exploreNLBA searches the configurations (state, head, tape) breadth first
+// and visits each one once, so it always terminates. Tapes are hash-consed
+// in fixed chunks: a successor that writes one cell shares every other chunk
+// with its parent, and equal tapes get the same id, so a configuration is
+// three integers. Each BFS level is expanded in parallel (read-only on the
+// stores, see parallelFor) and then merged serially, in frontier order, which
+// keeps the search deterministic for any thread count. The search stops as
+// soon as any branch accepts.
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "batch.h"
+#include "lba.h"
+
+// (state, symbol read) -> every (new state, symbol to write, head move)
+using NLBATransitions = std::multimap<std::pair<std::string, char>, std::tuple<std::string, char, char>>;
+
+// The moves of key (state, symbol) are moves[rowBegin[k] .. rowBegin[k + 1])
+// with k = state * 256 + symbol, packed as in LBATable
+struct NLBATable
+{
+    std::vector<std::string> names;           // Dense state id -> name
+    std::unordered_map<std::string, int> ids; // Name -> dense state id
+    std::vector<uint32_t> rowBegin;           // Per key, plus one
+    std::vector<uint32_t> moves;
+    uint32_t start = 0, accept = 0;
+    uint32_t fanout = 0; // Most moves under one key
+};
+
+inline NLBATable compileNLBA(const NLBATransitions &transitions, const std::string &start, const std::string &accept)
+{
+    NLBATable T;
+    auto id = [&](const std::string &name) {
+        auto [it, fresh] = T.ids.try_emplace(name, (int)T.names.size());
+        if (fresh)
+            T.names.push_back(name);
+        return (uint32_t)it->second;
+    };
+    T.start = id(start);
+    T.accept = id(accept);
+    for (auto &[key, value] : transitions)
+    {
+        id(key.first);
+        id(std::get<0>(value));
+    }
+
+    // Count the moves per key, then place them
+    T.rowBegin.assign(T.names.size() * 256 + 1, 0);
+    for (auto &[key, value] : transitions)
+        T.rowBegin[(id(key.first) << 8 | (unsigned char)key.second) + 1]++;
+    for (size_t k = 0; k + 1 < T.rowBegin.size(); k++)
+    {
+        T.fanout = std::max(T.fanout, T.rowBegin[k + 1]);
+        T.rowBegin[k + 1] += T.rowBegin[k];
+    }
+    T.moves.resize(transitions.size());
+    std::vector<uint32_t> fill(T.rowBegin.begin(), T.rowBegin.end() - 1);
+    for (auto &[key, value] : transitions)
+    {
+        auto &[newState, write, dir] = value;
+        LBAMove move = dir == 'R' ? MoveRight : dir == 'L' ? MoveLeft : Stay;
+        T.moves[fill[id(key.first) << 8 | (unsigned char)key.second]++] = LBATable::pack(id(newState), write, move);
+    }
+    return T;
+}
+
+// Hash-consed tapes of one fixed length. A tape is a row of chunk ids; equal
+// chunks and equal rows are stored once. Hashes are XORs of per-position
+// keys, so changing one cell updates both hashes in O(1).
+struct TapeStore
+{
+    static constexpr size_t chunkSize = 64;
+
+    size_t chunksPerTape = 0;
+    std::string chunkBytes;          // Chunk c is chunkBytes[c * chunkSize ..]
+    std::vector<uint64_t> chunkHash; // Per chunk
+    std::vector<uint32_t> rows;      // Tape t is rows[t * chunksPerTape ..]
+    std::vector<uint64_t> tapeHash;  // Per tape
+    // Hash -> id; on a collision the next key in the chain mix64(key) is used
+    std::unordered_map<uint64_t, uint32_t> chunkIndex, tapeIndex;
+
+    static uint64_t byteKey(size_t i, unsigned char c) { return mix64(i << 8 | c); }
+    static uint64_t chunkKey(size_t k, uint32_t chunk) { return mix64((uint64_t)k << 32 | chunk | 1ULL << 63); }
+
+    unsigned char at(uint32_t tape, size_t pos) const
+    {
+        return chunkBytes[rows[tape * chunksPerTape + pos / chunkSize] * chunkSize + pos % chunkSize];
+    }
+
+    // Id stored under `h` (or further along its chain) that satisfies same(), or -1
+    template <class Same>
+    static int64_t find(const std::unordered_map<uint64_t, uint32_t> &index, uint64_t h, Same same)
+    {
+        for (;; h = mix64(h))
+        {
+            auto it = index.find(h);
+            if (it == index.end())
+                return -1;
+            if (same(it->second))
+                return it->second;
+        }
+    }
+    static void insert(std::unordered_map<uint64_t, uint32_t> &index, uint64_t h, uint32_t id)
+    {
+        while (!index.try_emplace(h, id).second)
+            h = mix64(h);
+    }
+
+    // Chunk `chunk` with byte i replaced by c: its hash, and its id if stored
+    int64_t findChunk(uint32_t chunk, size_t i, unsigned char c, uint64_t &h) const
+    {
+        const char *old = &chunkBytes[chunk * chunkSize];
+        h = chunkHash[chunk] ^ byteKey(i, old[i]) ^ byteKey(i, c);
+        return find(chunkIndex, h, [&](uint32_t d) {
+            const char *s = &chunkBytes[d * chunkSize];
+            return (unsigned char)s[i] == c && std::memcmp(s, old, i) == 0 &&
+                   std::memcmp(s + i + 1, old + i + 1, chunkSize - i - 1) == 0;
+        });
+    }
+    uint32_t addChunk(uint32_t chunk, size_t i, unsigned char c, uint64_t h)
+    {
+        uint32_t id = chunkHash.size();
+        chunkBytes.resize((id + 1) * chunkSize);
+        std::memcpy(&chunkBytes[id * chunkSize], &chunkBytes[chunk * chunkSize], chunkSize);
+        chunkBytes[id * chunkSize + i] = c;
+        chunkHash.push_back(h);
+        insert(chunkIndex, h, id);
+        return id;
+    }
+
+    // Tape `tape` with chunk k replaced by `chunk`: its hash, and its id if stored
+    int64_t findTape(uint32_t tape, size_t k, uint32_t chunk, uint64_t &h) const
+    {
+        const uint32_t *old = &rows[tape * chunksPerTape];
+        h = tapeHash[tape] ^ chunkKey(k, old[k]) ^ chunkKey(k, chunk);
+        return find(tapeIndex, h, [&](uint32_t t) {
+            const uint32_t *r = &rows[t * chunksPerTape];
+            for (size_t j = 0; j < chunksPerTape; j++)
+                if (r[j] != (j == k ? chunk : old[j]))
+                    return false;
+            return true;
+        });
+    }
+    uint32_t addTape(uint32_t tape, size_t k, uint32_t chunk, uint64_t h)
+    {
+        uint32_t id = tapeHash.size();
+        rows.resize((id + 1) * chunksPerTape);
+        std::copy_n(&rows[tape * chunksPerTape], chunksPerTape, &rows[id * chunksPerTape]);
+        rows[id * chunksPerTape + k] = chunk;
+        tapeHash.push_back(h);
+        insert(tapeIndex, h, id);
+        return id;
+    }
+
+    // Store the input as tape 0 (chunks of the initial tape are not shared)
+    void reset(const std::string &input)
+    {
+        chunksPerTape = (input.size() + chunkSize - 1) / chunkSize;
+        chunkBytes.assign(chunksPerTape * chunkSize, 0);
+        std::memcpy(chunkBytes.data(), input.data(), input.size());
+        chunkHash.assign(chunksPerTape, 0);
+        rows.clear();
+        tapeHash.assign(1, 0);
+        chunkIndex.clear();
+        tapeIndex.clear();
+        for (size_t k = 0; k < chunksPerTape; k++)
+        {
+            for (size_t i = 0; i < chunkSize; i++)
+                chunkHash[k] ^= byteKey(i, chunkBytes[k * chunkSize + i]);
+            insert(chunkIndex, chunkHash[k], k);
+            rows.push_back(k);
+            tapeHash[0] ^= chunkKey(k, k);
+        }
+        insert(tapeIndex, tapeHash[0], 0);
+    }
+};
+
+// Explore every branch of the machine on `input` on `threads` workers.
+// Returns Accepts as soon as one branch accepts, Rejects once every reachable
+// configuration has been visited, and StepLimit if more than maxConfigs
+// configurations (0 = no limit) would be needed. `visited`, if given,
+// receives the number of configurations stored.
+inline LBAVerdict exploreNLBA(const NLBATable &T, const std::string &input, unsigned threads = 1,
+                              size_t maxConfigs = 0, size_t *visited = nullptr)
+{
+    struct Config
+    {
+        uint32_t state;
+        int head;
+        uint32_t tape;
+        bool operator==(const Config &o) const { return state == o.state && head == o.head && tape == o.tape; }
+    };
+    struct ConfigHash
+    {
+        size_t operator()(const Config &c) const { return mix64((uint64_t)c.state << 32 ^ (uint32_t)c.head ^ (uint64_t)c.tape << 20); }
+    };
+    // A successor proposed by the parallel phase. Ids still unknown (-1) are
+    // created by the serial merge.
+    struct Candidate
+    {
+        Config next;
+        uint32_t parentTape;
+        int pos;                 // Cell written with a new symbol, -1 if none
+        unsigned char symbol;
+        int64_t chunk, tape;     // Ids, -1 if not stored yet
+        uint64_t chunkH;
+    };
+
+    QueryStats stats("exploreNLBA", input.size());
+    const int n = input.size();
+    const size_t parallelMin = 256; // Smaller levels are expanded serially
+    size_t count;
+    if (!visited)
+        visited = &count;
+    if (!maxConfigs)
+        maxConfigs = SIZE_MAX;
+
+    TapeStore store;
+    store.reset(input);
+    std::unordered_set<Config, ConfigHash> seen;
+    std::vector<Config> frontier = {{T.start, 0, 0}}, next;
+    seen.insert(frontier[0]);
+    std::vector<Candidate> slots;
+    std::vector<uint32_t> produced;
+    std::atomic<bool> accepted{false};
+
+    // Record the verdict, and with ENGINE_STATS the memory the search holds:
+    // the configuration set and the tape store
+    auto finish = [&](LBAVerdict verdict) {
+        if constexpr (engineStats)
+            stats.peak(ArenaBytes, seen.size() * sizeof(Config) + store.chunkBytes.size() +
+                                       (store.chunkHash.size() + store.tapeHash.size()) * sizeof(uint64_t) +
+                                       store.rows.size() * sizeof(uint32_t) +
+                                       (store.chunkIndex.size() + store.tapeIndex.size()) * 2 * sizeof(uint64_t));
+        return stats.result(verdict);
+    };
+
+    // Propose the successors of frontier[i] into its slots
+    auto expand = [&](size_t i) {
+        produced[i] = 0;
+        if (accepted.load(std::memory_order_relaxed))
+            return;
+        Config c = frontier[i];
+        if (c.head < 0 || c.head >= n)
+        {
+            // Off the left end: this branch accepts in the accept state
+            if (c.head < 0 && c.state == T.accept)
+                accepted = true;
+            return;
+        }
+        unsigned char sym = store.at(c.tape, c.head);
+        uint32_t key = c.state << 8 | sym;
+        if (T.rowBegin[key] == T.rowBegin[key + 1])
+        {
+            // Stuck: accept in the accept state
+            if (c.state == T.accept)
+                accepted = true;
+            return;
+        }
+        for (uint32_t m = T.rowBegin[key]; m < T.rowBegin[key + 1]; m++)
+        {
+            uint32_t e = T.moves[m];
+            LBAMove move = LBATable::move(e);
+            Candidate cand{{LBATable::target(e), c.head + (move == MoveRight) - (move == MoveLeft), c.tape},
+                           c.tape, -1, LBATable::written(e), 0, c.tape, 0};
+            if (move == Stay && cand.next.state == T.accept)
+            {
+                accepted = true;
+                return;
+            }
+            if (cand.symbol != sym)
+            {
+                cand.pos = c.head;
+                size_t k = c.head / TapeStore::chunkSize, at = c.head % TapeStore::chunkSize;
+                uint64_t tapeH;
+                cand.chunk = store.findChunk(store.rows[c.tape * store.chunksPerTape + k], at, cand.symbol, cand.chunkH);
+                cand.tape = cand.chunk < 0 ? -1 : store.findTape(c.tape, k, cand.chunk, tapeH);
+                if (cand.tape >= 0)
+                    cand.next.tape = cand.tape;
+            }
+            if (cand.tape >= 0 && seen.count(cand.next))
+                continue;
+            slots[i * T.fanout + produced[i]++] = cand;
+        }
+    };
+
+    *visited = 1;
+    stats.phase(Search);
+    while (!frontier.empty())
+    {
+        produced.assign(frontier.size(), 0);
+        slots.resize(frontier.size() * T.fanout);
+        stats.add(Expanded, frontier.size());
+        stats.sample(LevelWidth, frontier.size());
+        stats.peak(FrontierPeak, frontier.size());
+        stats.peak(FrontierBytes, frontier.size() * sizeof(Config) + slots.size() * sizeof(Candidate));
+        parallelFor(frontier.size(), frontier.size() < parallelMin ? 1 : threads, expand);
+        if (accepted)
+            return finish(Accepts);
+
+        // Merge in frontier order: create missing chunks and tapes, dedup
+        next.clear();
+        for (size_t i = 0; i < frontier.size(); i++)
+            for (uint32_t j = 0; j < produced[i]; j++)
+            {
+                Candidate &cand = slots[i * T.fanout + j];
+                stats.add(Generated);
+                if (cand.tape < 0)
+                {
+                    size_t k = cand.pos / TapeStore::chunkSize, at = cand.pos % TapeStore::chunkSize;
+                    uint32_t old = store.rows[cand.parentTape * store.chunksPerTape + k];
+                    if (cand.chunk < 0 && (cand.chunk = store.findChunk(old, at, cand.symbol, cand.chunkH)) < 0)
+                        cand.chunk = store.addChunk(old, at, cand.symbol, cand.chunkH);
+                    uint64_t tapeH;
+                    if ((cand.tape = store.findTape(cand.parentTape, k, cand.chunk, tapeH)) < 0)
+                        cand.tape = store.addTape(cand.parentTape, k, cand.chunk, tapeH);
+                    cand.next.tape = cand.tape;
+                }
+                if (!seen.insert(cand.next).second)
+                {
+                    stats.add(Duplicates);
+                    continue;
+                }
+                if (++*visited > maxConfigs)
+                    return finish(StepLimit);
+                next.push_back(cand.next);
+            }
+        frontier.swap(next);
+    }
+    return finish(Rejects);
+}
@@ -1,75 +1,72 @@
 #include <iostream>
-#include <vector>
-#include <queue>
-#include <unordered_map>
+#include <fstream>
 #include <string>
+#include "batch.h"
+#include "cnf.h"
+#include "pda.h"
 using namespace std;
 
-// Struct to store a derivation step
-struct Step
-{
-    string derived; // Current string derived
-    string path;    // Derivation path (used internally)
-};
+// PDA to CFG: convert a pushdown automaton to a grammar for its language
+// with the lazy triple construction (pda.h), print it, then decide strings
+// with CYK on the grammar brought to CNF.
+//   pda-cfg [--pda FILE] [--batch [file] [--threads N]] [--stats FILE]
+// FILE is in printPDA format; without it, the example PDA below is used.
+
+// Example PDA: L = { a^n b^n | n >= 1 }, accepting by empty stack. q0 pushes
+// an A per a, q1 pops one per b and finally pops the bottom Z.
+PDA examplePDA = makePDA("q0", 'Z', {},
+                         {
+                             {"q0", 'a', 'Z', "q0", "AZ"},
+                             {"q0", 'a', 'A', "q0", "AA"},
+                             {"q0", 'b', 'A', "q1", ""},
+                             {"q1", 'b', 'A', "q1", ""},
+                             {"q1", 0, 'Z', "q1", ""},
+                         });
 
-bool simulateCFG(const string &input, unordered_map<char, vector<string>> &grammar)
+int main(int argc, char *argv[])
 {
-    queue<Step> q;
-    q.push({"S", "S"}); // Start symbol
+    // --stats FILE: one JSON line of conversion counters (see stats.h)
+    if (!openStats(argc, argv))
+        return 1;
 
-    while (!q.empty())
+    // --pda FILE: convert the PDA in FILE instead of the example
+    string pdaPath = flagText(argc, argv, "--pda"), error;
+    PDA M = examplePDA;
+    if (!pdaPath.empty())
     {
-        Step current = q.front();
-        q.pop();
-
-        // Accept if fully expanded string matches input
-        if (current.derived == input)
-        {
-            cout << "\nString accepted!\n";
-            cout << "Derivation: " << current.path << "\n";
-            return true;
-        }
-
-        // Skip strings that are too long
-        if (current.derived.size() > input.size())
-            continue;
-
-        // Expand the first non-terminal
-        for (int i = 0; i < current.derived.size(); ++i)
+        ifstream file(pdaPath);
+        if (!file || !readPDA(file, M, error))
         {
-            char c = current.derived[i];
-            if (grammar.count(c))
-            {
-                for (auto &prod : grammar[c])
-                {
-                    // Generate next derived string
-                    string next = current.derived.substr(0, i) + prod + current.derived.substr(i + 1);
-                    // Build new path
-                    string nextPath = current.path + " -> " + next;
-                    q.push({next, nextPath});
-                }
-                break; // Only expand first non-terminal at a time
-            }
+            cerr << pdaPath << ": " << (file ? error : "cannot open") << endl;
+            return 1;
         }
     }
 
-    // If BFS finishes without finding the input, it's rejected
-    cout << "\nString rejected!\n";
-    return false;
-}
+    PDAGrammar converted = pdaToGrammar(M);
+    Grammar cnf = converted.grammar;
+    convertToCNF(cnf);
+    CNFTables T = compileCNF(cnf);
+
+    // --batch [file] [--threads N]: decide every line of the file (or stdin), no output but the verdicts
+    string batchPath;
+    if (batchRequested(argc, argv, batchPath))
+        return runBatch(batchPath, [&](const string &s) { return cykRecognize(T, s); }, batchThreads(argc, argv));
 
-int main()
-{
     cout << "\nPDA to CFG\n";
-    // Define CFG rules
-    unordered_map<char, vector<string>> grammar;
-    grammar['S'] = {"aSb", "ab"}; // Example CFG
+    if (pdaPath.empty())
+        cout << "Example PDA: L = { a^n b^n | n >= 1 }, by empty stack\n";
+    printPDA(cout, M);
+
+    const Grammar &G = converted.grammar;
+    cout << "\nCFG (" << G.productionCount() << " rules; the full construction has "
+         << converted.fullNonterminals << " nonterminals and " << converted.fullRules << " rules):\n";
+    for (Symbol A : nonterminalsByName(G))
+        if (converted.triples.count(A))
+            cout << "# " << G.name(A) << " = " << converted.triples[A] << "\n";
+    printRules(G);
 
-    // Print example CFG
-    cout << "Example CFG: S -> aSb | ab\n";
     string input;
     cout << "\nEnter a string to test: ";
-    cin >> input;
-
-    simulateCFG(input, grammar);
+    if (cin >> input)
+        cout << (cykRecognize(T, input) ? "\nString accepted!\n" : "\nString rejected!\n");
 }
@@ -0,0 +1,336 @@
+#pragma once
+// Pushdown automata and their conversion to context-free grammars.
+//
+// pdaToGrammar is the triple construction: nonterminal [p X q] derives the
+// input read while the machine goes from state p with X on top of the stack
+// to state q with that X popped, and S → [start bottom q] for every q. Built
+// the textbook way that is |Q|^2·|Γ| nonterminals and |Q|^k rules per move
+// pushing k symbols, almost all of them useless. Here triples are generated
+// on demand instead, the way a GLL parser explores calls:
+//   - a "call" (p, X) is only opened once some rule needs a [p X ·], starting
+//     from (start, bottom), so every triple is reachable;
+//   - a rule [p X r_k] → a [q Y1 r1] [r1 Y2 r2] ... [r_k-1 Yk r_k] is grown one
+//     symbol at a time, and r_i only ranges over the states in which call
+//     (r_i-1, Yi) is already known to end, so every triple is productive.
+// A call that ends in a new state resumes the partial rules waiting on it.
+// The work and the output are proportional to the triples actually used.
+#include <algorithm>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "grammar.h"
+#include "stats.h"
+
+// In state `from` with `pop` on top of the stack, read `input` (0 for an
+// ε-move), go to `to` and replace `pop` by `push`, its first symbol on top
+// ("" just pops)
+struct PDATransition
+{
+    std::string from;
+    char input;
+    char pop;
+    std::string to;
+    std::string push;
+};
+
+struct PDA
+{
+    std::vector<std::string> states; // In order of appearance, start first
+    std::string inputAlphabet, stackAlphabet;
+    std::vector<PDATransition> transitions;
+    std::string start;
+    char bottom = 'Z';               // The stack starts as this one symbol
+    std::vector<std::string> accept; // Final states; none: accept by empty stack
+};
+
+// Build a PDA from its transitions, collecting the states and alphabets
+inline PDA makePDA(const std::string &start, char bottom, const std::vector<std::string> &accept,
+                   const std::vector<PDATransition> &transitions)
+{
+    PDA M;
+    M.start = start, M.bottom = bottom, M.accept = accept, M.transitions = transitions;
+    auto state = [&](const std::string &q) {
+        if (std::find(M.states.begin(), M.states.end(), q) == M.states.end())
+            M.states.push_back(q);
+    };
+    auto symbol = [](std::string &alphabet, char c) {
+        if (c && alphabet.find(c) == std::string::npos)
+            alphabet += c;
+    };
+    state(start);
+    symbol(M.stackAlphabet, bottom);
+    for (auto &q : accept)
+        state(q);
+    for (auto &t : transitions)
+    {
+        state(t.from), state(t.to);
+        symbol(M.inputAlphabet, t.input);
+        symbol(M.stackAlphabet, t.pop);
+        for (char c : t.push)
+            symbol(M.stackAlphabet, c);
+    }
+    return M;
+}
+
+// Text form of a PDA; '#' starts a comment, symbols are single characters
+// and ε (or -) stands for no input or an empty push:
+//   start q0
+//   bottom Z
+//   accept q2        (optional, any number of states; none: by empty stack)
+//   q0 a Z -> q0 AZ
+//   q1 ε Z -> q1 ε
+inline void printPDA(std::ostream &out, const PDA &M)
+{
+    out << "start " << M.start << "\nbottom " << M.bottom << "\n";
+    if (!M.accept.empty())
+    {
+        out << "accept";
+        for (auto &q : M.accept)
+            out << " " << q;
+        out << "\n";
+    }
+    for (auto &t : M.transitions)
+        out << t.from << " " << (t.input ? std::string(1, t.input) : "ε") << " " << t.pop << " -> " << t.to << " "
+            << (t.push.empty() ? "ε" : t.push) << "\n";
+}
+
+// Read the printPDA form. Input symbols can't be uppercase letters, which
+// name nonterminals in the converted grammar. On a syntax error, returns
+// false with `error` naming the line.
+inline bool readPDA(std::istream &in, PDA &M, std::string &error)
+{
+    std::string start, line;
+    char bottom = 0;
+    std::vector<std::string> accept;
+    std::vector<PDATransition> transitions;
+    for (int number = 1; std::getline(in, line); number++)
+    {
+        std::istringstream words(line.substr(0, line.find('#')));
+        std::string state, read, pop, arrow, next, push, rest;
+        if (!(words >> state))
+            continue;
+        auto fail = [&](const std::string &why) {
+            error = "line " + std::to_string(number) + ": " + why;
+            return false;
+        };
+        if (state == "start" || state == "bottom")
+        {
+            if (!(words >> next) || words >> rest || (state == "bottom" && next.size() != 1))
+                return fail(state == "start" ? "expected start STATE" : "expected bottom SYMBOL");
+            if (state == "start")
+                start = next;
+            else
+                bottom = next[0];
+            continue;
+        }
+        if (state == "accept")
+        {
+            while (words >> next)
+                accept.push_back(next);
+            continue;
+        }
+        auto empty = [](const std::string &s) { return s == "ε" || s == "-"; };
+        if (!(words >> read >> pop >> arrow >> next >> push) || words >> rest || arrow != "->" ||
+            (read.size() != 1 && !empty(read)) || pop.size() != 1)
+            return fail("expected STATE INPUT|ε TOP -> STATE PUSH|ε");
+        if (!empty(read) && isupper((unsigned char)read[0]))
+            return fail("input symbols can't be uppercase letters");
+        transitions.push_back({state, empty(read) ? '\0' : read[0], pop[0], next, empty(push) ? "" : push});
+    }
+    if (start.empty() || !bottom)
+    {
+        error = "the start state or bottom symbol is missing";
+        return false;
+    }
+    M = makePDA(start, bottom, accept, transitions);
+    return true;
+}
+
+// Grammar of a PDA's language. Triple nonterminals are named T1, T2, ... so
+// the rules read back with readGrammar; `triples` says what each stands for.
+struct PDAGrammar
+{
+    Grammar grammar;
+    std::unordered_map<Symbol, std::string> triples; // Nonterminal -> "[p X q]"
+    size_t calls = 0, items = 0;                     // (p, X) pairs opened, partial rules built
+    size_t fullNonterminals = 0, fullRules = 0;      // What the textbook construction would emit (saturating)
+};
+
+inline PDAGrammar pdaToGrammar(const PDA &M)
+{
+    QueryStats stats("pdaToGrammar", M.transitions.size());
+
+    // Dense state ids. Acceptance by final state becomes acceptance by empty
+    // stack: a new start state puts a new bottom marker under the old bottom,
+    // and every final state may ε-move to a drain state that empties the stack.
+    std::unordered_map<std::string, uint32_t> ids;
+    std::vector<std::string> names;
+    auto id = [&](const std::string &q) {
+        auto [it, fresh] = ids.try_emplace(q, (uint32_t)names.size());
+        if (fresh)
+            names.push_back(q);
+        return it->second;
+    };
+    struct Move
+    {
+        uint32_t from, to;
+        unsigned char input, pop;
+        std::string push;
+    };
+    std::vector<Move> moves;
+    for (auto &q : M.states)
+        id(q);
+    for (auto &t : M.transitions)
+        moves.push_back({id(t.from), id(t.to), (unsigned char)t.input, (unsigned char)t.pop, t.push});
+    uint32_t start = id(M.start);
+    unsigned char bottom = M.bottom;
+    std::string marker = "⊥"; // How the added bottom marker is printed
+    if (!M.accept.empty())
+    {
+        unsigned char mark = 1;
+        while (M.stackAlphabet.find((char)mark) != std::string::npos)
+            mark++;
+        uint32_t begin = id("start'"), drain = id("drain'");
+        std::string stack = M.stackAlphabet + (char)mark;
+        moves.push_back({begin, start, 0, mark, std::string(1, (char)bottom) + (char)mark});
+        for (char X : stack)
+        {
+            for (auto &q : M.accept)
+                moves.push_back({id(q), drain, 0, (unsigned char)X, ""});
+            moves.push_back({drain, drain, 0, (unsigned char)X, ""});
+        }
+        start = begin, bottom = mark;
+    }
+    std::unordered_map<uint32_t, std::vector<uint32_t>> movesByTop; // state << 8 | top -> moves
+    for (uint32_t m = 0; m < moves.size(); m++)
+        movesByTop[moves[m].from << 8 | moves[m].pop].push_back(m);
+
+    PDAGrammar out;
+    Grammar &G = out.grammar;
+    G.start = G.symbols.intern("S");
+    std::vector<Alternatives> lists;
+    std::unordered_map<uint64_t, Symbol> tripleIds;
+    auto stackName = [&](unsigned char X) { return X == bottom && !M.accept.empty() ? marker : std::string(1, X); };
+    auto triple = [&](uint32_t p, unsigned char X, uint32_t q) {
+        auto [it, fresh] = tripleIds.try_emplace((uint64_t)p << 40 | (uint64_t)X << 32 | q, 0);
+        if (fresh)
+        {
+            it->second = G.symbols.intern("T" + std::to_string(tripleIds.size()));
+            out.triples[it->second] = "[" + names[p] + " " + stackName(X) + " " + names[q] + "]";
+        }
+        return it->second;
+    };
+
+    // A call (p, X) ends in the states `ends`; `waiting` are the partial
+    // rules that need one of its triples next. A partial rule of move m has
+    // matched the first `done` pushed symbols and is in `state`; `parent` is
+    // the same rule one symbol shorter, so the chain of states r_i is a path.
+    struct Call
+    {
+        uint32_t p;
+        unsigned char X;
+        std::vector<uint32_t> ends, waiting;
+    };
+    struct Item
+    {
+        uint32_t move, call, done, state;
+        int parent;
+    };
+    std::vector<Call> calls;
+    std::unordered_map<uint32_t, uint32_t> callIndex;
+    std::vector<Item> items;
+    std::vector<uint32_t> work;
+
+    auto addItem = [&](Item item) {
+        items.push_back(item);
+        work.push_back(items.size() - 1);
+        stats.add(Generated);
+        stats.peak(FrontierPeak, work.size());
+    };
+    auto open = [&](uint32_t p, unsigned char X) {
+        auto [it, fresh] = callIndex.try_emplace(p << 8 | X, (uint32_t)calls.size());
+        if (fresh)
+        {
+            calls.push_back({p, X, {}, {}});
+            if (auto found = movesByTop.find(p << 8 | X); found != movesByTop.end())
+                for (uint32_t m : found->second)
+                    addItem({m, it->second, 0, moves[m].to, -1});
+        }
+        return it->second;
+    };
+
+    open(start, bottom);
+    stats.phase(Search);
+    while (!work.empty())
+    {
+        uint32_t k = work.back();
+        work.pop_back();
+        stats.add(Expanded);
+        Item item = items[k];
+        const Move &m = moves[item.move];
+        if (item.done < m.push.size())
+        {
+            // Needs [state Y ·] next: wait on that call, and go on with every end it already has
+            uint32_t c = open(item.state, (unsigned char)m.push[item.done]);
+            calls[c].waiting.push_back(k);
+            for (size_t e = 0; e < calls[c].ends.size(); e++)
+                addItem({item.move, item.call, item.done + 1, calls[c].ends[e], (int)k});
+            continue;
+        }
+
+        // Complete: emit [p X state] → a [r0 Y1 r1] ... and resume the waiters on a new end
+        std::vector<uint32_t> path;
+        for (int j = k; j >= 0; j = items[j].parent)
+            path.push_back(items[j].state);
+        std::reverse(path.begin(), path.end());
+        Call &call = calls[item.call];
+        std::vector<Symbol> rhs;
+        if (m.input)
+            rhs.push_back(G.symbols.intern(std::string(1, m.input)));
+        for (size_t i = 0; i < m.push.size(); i++)
+            rhs.push_back(triple(path[i], (unsigned char)m.push[i], path[i + 1]));
+        Symbol A = triple(call.p, call.X, item.state);
+        lists.resize(G.symbols.size());
+        lists[A].add(rhs);
+        if (std::find(call.ends.begin(), call.ends.end(), item.state) != call.ends.end())
+            continue;
+        call.ends.push_back(item.state);
+        for (uint32_t w : std::vector<uint32_t>(call.waiting))
+        {
+            Item waiter = items[w];
+            addItem({waiter.move, waiter.call, waiter.done + 1, item.state, (int)w});
+        }
+    }
+
+    for (uint32_t q : calls[callIndex[start << 8 | bottom]].ends)
+    {
+        lists.resize(G.symbols.size());
+        lists[G.start].add({triple(start, bottom, q)});
+    }
+    lists.resize(G.symbols.size());
+    pack(G, lists);
+
+    // Every triple is productive and was opened from the start, but a call
+    // can end only inside rules that never complete: drop those
+    stats.add(Pruned, removeUselessSymbols(G).rules);
+    stats.peak(ArenaBytes, items.size() * sizeof(Item) + calls.size() * sizeof(Call));
+    out.calls = calls.size(), out.items = items.size();
+
+    // Textbook size: |Q|^2·|Γ| triples plus S; |Q| start rules and |Q|^k per move pushing k
+    auto times = [](size_t a, size_t b) { return b && a > SIZE_MAX / b ? SIZE_MAX : a * b; };
+    size_t Q = names.size(), stack = M.stackAlphabet.size() + !M.accept.empty();
+    out.fullNonterminals = std::min(times(times(Q, Q), stack), SIZE_MAX - 1) + 1;
+    out.fullRules = Q;
+    for (auto &move : moves)
+    {
+        size_t rules = 1;
+        for (size_t i = 0; i < move.push.size(); i++)
+            rules = times(rules, Q);
+        out.fullRules = rules > SIZE_MAX - out.fullRules ? SIZE_MAX : out.fullRules + rules;
+    }
+    return out;
+}
@@ -0,0 +1,60 @@
+# Regression check for cfgc --cnf and cnf2 --artifact: compile GRAMMAR to an
+# artifact, then run cnf2 on every line of CASES ("input accept|reject") and
+# compare the verdicts. ARGS (optional) are extra cnf2 flags, e.g. --threads 4.
+# With GNF (--gnf or --gnf-matrix) and GNF2, the grammar is first compiled
+# with cfgc GNF and printed back by gnf2 --artifact, and the checks run on
+# that printout. Run through ctest (see CMakeLists.txt):
+#   cmake -DCFGC=... -DCNF2=... -DGRAMMAR=... -DCASES=... -DWORK=... [-DARGS=...]
+#         [-DGNF=... -DGNF2=...] -P cnf-artifact.cmake
+get_filename_component(name ${GRAMMAR} NAME_WE)
+if(GNF)
+    set(name ${name}${GNF})
+    execute_process(COMMAND ${CFGC} ${GNF} ${GRAMMAR} ${WORK}/${name}.art RESULT_VARIABLE status ERROR_VARIABLE log)
+    if(NOT status EQUAL 0)
+        message(FATAL_ERROR "cfgc ${GNF} ${GRAMMAR} failed:\n${log}")
+    endif()
+    execute_process(COMMAND ${GNF2} --artifact ${WORK}/${name}.art OUTPUT_FILE ${WORK}/${name}.g
+                    RESULT_VARIABLE status)
+    if(NOT status EQUAL 0)
+        message(FATAL_ERROR "gnf2 --artifact ${WORK}/${name}.art failed")
+    endif()
+    set(GRAMMAR ${WORK}/${name}.g)
+endif()
+set(artifact ${WORK}/${name}.art)
+execute_process(COMMAND ${CFGC} --cnf ${GRAMMAR} ${artifact} RESULT_VARIABLE status ERROR_VARIABLE log)
+if(NOT status EQUAL 0)
+    message(FATAL_ERROR "cfgc --cnf ${GRAMMAR} failed:\n${log}")
+endif()
+
+file(STRINGS ${CASES} cases ENCODING UTF-8)
+set(failures 0)
+foreach(line ${cases})
+    if(line MATCHES "^#" OR line STREQUAL "")
+        continue()
+    endif()
+    string(REGEX MATCH "^([^ ]+) +(accept|reject)$" _ "${line}")
+    if(NOT CMAKE_MATCH_2)
+        message(FATAL_ERROR "${CASES}: bad line '${line}'")
+    endif()
+    set(input ${CMAKE_MATCH_1})
+    set(expected ${CMAKE_MATCH_2})
+    file(WRITE ${WORK}/${name}.in "${input}\n")
+    execute_process(COMMAND ${CNF2} --artifact ${artifact} ${ARGS} INPUT_FILE ${WORK}/${name}.in OUTPUT_VARIABLE out
+                    ERROR_QUIET RESULT_VARIABLE status)
+    if(NOT status EQUAL 0)
+        set(verdict "exit status ${status}")
+    elseif(out MATCHES "Accepted")
+        set(verdict accept)
+    elseif(out MATCHES "Rejected")
+        set(verdict reject)
+    else()
+        set(verdict "no verdict")
+    endif()
+    if(NOT verdict STREQUAL expected)
+        message(SEND_ERROR "${name}: '${input}' gave ${verdict}, expected ${expected}")
+        math(EXPR failures "${failures} + 1")
+    endif()
+endforeach()
+if(failures)
+    message(FATAL_ERROR "${failures} wrong verdicts")
+endif()
@@ -0,0 +1,7 @@
+# cfgc --info output for S → aSb | ab, fed back in with one rule added by
+# hand. The grammar is read as a user file, and the mixed rule cX2 must get
+# a terminal variable other than the existing X1 and X2
+S → X1Y1 | X1X2 | cX2
+X1 → a
+X2 → b
+Y1 → SX2
@@ -0,0 +1,3 @@
+# Immediate left recursion: the substitution GNF must rewrite S → Sb | ba
+# without leaving an ε-rule for the new variable behind
+S → Sb | ba
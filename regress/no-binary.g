@@ -0,0 +1,3 @@
+# No binary rules: the CYK chart has no rule words. Inputs of 256 symbols
+# or more take the parallel path under --threads
+S → a
@@ -0,0 +1,4 @@
+# The grammar already has a variable X1: the terminal variables cfgc --cnf
+# introduces (X<n>) must not be merged into it
+S → aX1 | b
+X1 → cc
@@ -0,0 +1,249 @@
+#pragma once
+// Per-query instrumentation for the search engines. An engine creates one
+// QueryStats per call and reports what its search did: frontier expansions,
+// duplicates, pruning, peak frontier size, bytes held, time per phase, and
+// log2 histograms. When the QueryStats goes out of scope it writes one JSON
+// line to the stats sink (--stats FILE, "-" for stderr):
+//
+//   {"engine": "simulateCFG", "input_length": 6, "verdict": "accept", "ns": 5123,
+//    "phases_ns": {"setup": 801, "search": 4322}, "counters": {"expanded": 7, ...},
+//    "histograms": {"form_length": {"1": 1, "2": 2, "4": 4}}}
+//
+// Only counters and histograms the engine touched are written; a histogram
+// bucket is keyed by its lower bound (bucket "4" counts values 4..7).
+//
+// Collection is compiled in only with -DENGINE_STATS (cmake -DENGINE_STATS=ON).
+// Otherwise QueryStats is an empty class whose methods do nothing, so the
+// calls in the hot loops compile to nothing; work done only to feed the stats
+// is guarded by `if constexpr (engineStats)`.
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+
+#ifdef ENGINE_STATS
+constexpr bool engineStats = true;
+#else
+constexpr bool engineStats = false;
+#endif
+
+enum StatCounter : int
+{
+    Expanded,      // Items taken off the frontier
+    Generated,     // Successors produced
+    Duplicates,    // Successors dropped as already seen
+    Pruned,        // Items dropped as unable to lead to acceptance
+    FrontierPeak,  // Most items waiting at once
+    FrontierBytes, // Most bytes held by waiting items
+    ArenaBytes,    // Bytes of derivation records, GSS nodes, stored configurations
+    Steps,         // Single machine steps
+    MacroSteps,    // Sweeps taken as one step
+    GSSNodes,
+    GSSEdges,
+    Pops, // Nonterminals matched (GLL returns)
+    CounterCount
+};
+
+enum StatHistogram : int
+{
+    FormLength,  // Length of each expanded sentential form
+    SweepLength, // Steps covered by each macro-step
+    PopFanout,   // Stacks a GLL return continues on
+    LevelWidth,  // Configurations per BFS level
+    HistogramCount
+};
+
+enum StatPhase : int
+{
+    Setup,  // Precomputation before the search
+    Search,
+    Replay, // Rebuilding a derivation or transition path to print
+    PhaseCount
+};
+
+// Where the JSON lines go. Lines from concurrent queries (--batch --threads)
+// are written whole, one at a time.
+class StatsSink
+{
+  public:
+    static StatsSink &global()
+    {
+        static StatsSink sink;
+        return sink;
+    }
+
+    // Append to `path`, or write to stderr for "-"
+    bool open(const std::string &path)
+    {
+        out = path == "-" ? stderr : std::fopen(path.c_str(), "a");
+        if (out && out != stderr)
+            std::setvbuf(out, nullptr, _IOLBF, 1 << 16);
+        return out != nullptr;
+    }
+    bool active() const { return out != nullptr; }
+
+    void write(const std::string &line)
+    {
+        std::lock_guard<std::mutex> hold(lock);
+        std::fputs(line.c_str(), out);
+    }
+
+    ~StatsSink()
+    {
+        if (out && out != stderr)
+            std::fclose(out);
+    }
+
+  private:
+    std::FILE *out = nullptr;
+    std::mutex lock;
+};
+
+// "--stats FILE" in argv: send the stats lines there. False only if FILE
+// can't be opened; without -DENGINE_STATS there is nothing to send, which is
+// reported once.
+inline bool openStats(int argc, char *argv[])
+{
+    for (int i = 1; i + 1 < argc; i++)
+        if (std::strcmp(argv[i], "--stats") == 0)
+        {
+            if (!engineStats)
+            {
+                std::cerr << "--stats: built without ENGINE_STATS, no stats are collected\n";
+                return true;
+            }
+            if (StatsSink::global().open(argv[i + 1]))
+                return true;
+            std::cerr << "Cannot write " << argv[i + 1] << "\n";
+            return false;
+        }
+    return true;
+}
+
+template <bool Enabled>
+class BasicQueryStats;
+
+// Compiled out: every call is empty and inlined away
+template <>
+class BasicQueryStats<false>
+{
+  public:
+    BasicQueryStats(const char *, size_t) {}
+    void add(StatCounter, uint64_t = 1) {}
+    void peak(StatCounter, uint64_t) {}
+    void rise(StatCounter, uint64_t) {}
+    void fall(StatCounter, uint64_t) {}
+    void sample(StatHistogram, uint64_t) {}
+    void phase(StatPhase) {}
+    template <class Verdict>
+    Verdict result(Verdict v) { return v; }
+};
+
+template <>
+class BasicQueryStats<true>
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    BasicQueryStats(const char *engine, size_t inputLength)
+        : engine(engine), inputLength(inputLength), started(Clock::now()), phaseStarted(started)
+    {
+    }
+    BasicQueryStats(const BasicQueryStats &) = delete;
+
+    void add(StatCounter c, uint64_t n = 1) { counters[c] += n, used |= 1u << c; }
+    void peak(StatCounter c, uint64_t v)
+    {
+        if (v > counters[c])
+            counters[c] = v;
+        used |= 1u << c;
+    }
+    // A level that goes up and down (bytes in the frontier); its counter keeps the peak
+    void rise(StatCounter c, uint64_t n) { peak(c, levels[c] += n); }
+    void fall(StatCounter c, uint64_t n) { levels[c] -= n; }
+    void sample(StatHistogram h, uint64_t v)
+    {
+        histograms[h][v ? 64 - __builtin_clzll(v) : 0]++; // 0, then [2^(b-1), 2^b)
+        usedHistograms |= 1u << h;
+    }
+    // End the current phase and start `p`
+    void phase(StatPhase p)
+    {
+        Clock::time_point now = Clock::now();
+        phases[current] += elapsed(phaseStarted, now);
+        usedPhases |= 1u << current;
+        current = p, phaseStarted = now;
+    }
+    // Record the verdict on its way out: return stats.result(Accepts)
+    template <class Verdict>
+    Verdict result(Verdict v)
+    {
+        verdict = (int)v;
+        return v;
+    }
+
+    ~BasicQueryStats()
+    {
+        if (!StatsSink::global().active())
+            return;
+        phase(current);
+        static const char *const counterNames[] = {
+            "expanded",    "generated", "duplicates", "pruned",    "frontier_peak", "frontier_bytes_peak",
+            "arena_bytes", "steps",     "macro_steps", "gss_nodes", "gss_edges",     "pops"};
+        static const char *const histogramNames[] = {"form_length", "sweep_length", "pop_fanout", "level_width"};
+        static const char *const phaseNames[] = {"setup", "search", "replay"};
+        static const char *const verdictNames[] = {"reject", "accept", "loops", "step-limit"};
+
+        std::string line = "{\"engine\": \"" + std::string(engine) + "\", \"input_length\": " +
+                           std::to_string(inputLength) + ", \"verdict\": \"" +
+                           (verdict >= 0 && verdict < 4 ? verdictNames[verdict] : "none") + "\", \"ns\": " +
+                           std::to_string(elapsed(started, Clock::now()));
+        const char *comma = "";
+        line += ", \"phases_ns\": {";
+        for (int p = 0; p < PhaseCount; p++)
+            if (usedPhases >> p & 1)
+                line += comma + ("\"" + std::string(phaseNames[p]) + "\": ") + std::to_string(phases[p]), comma = ", ";
+        comma = "";
+        line += "}, \"counters\": {";
+        for (int c = 0; c < CounterCount; c++)
+            if (used >> c & 1)
+                line += comma + ("\"" + std::string(counterNames[c]) + "\": ") + std::to_string(counters[c]),
+                    comma = ", ";
+        comma = "";
+        line += "}, \"histograms\": {";
+        for (int h = 0; h < HistogramCount; h++)
+            if (usedHistograms >> h & 1)
+            {
+                line += comma + ("\"" + std::string(histogramNames[h]) + "\": {"), comma = ", ";
+                const char *inner = "";
+                for (int b = 0; b < 65; b++)
+                    if (histograms[h][b])
+                        line += inner + ("\"" + std::to_string(b ? 1ull << (b - 1) : 0) + "\": ") +
+                                    std::to_string(histograms[h][b]),
+                            inner = ", ";
+                line += "}";
+            }
+        line += "}}\n";
+        StatsSink::global().write(line);
+    }
+
+  private:
+    const char *engine;
+    size_t inputLength;
+    Clock::time_point started, phaseStarted;
+    StatPhase current = Setup;
+    int verdict = -1;
+    uint32_t used = 0, usedHistograms = 0, usedPhases = 0;
+    uint64_t counters[CounterCount] = {}, levels[CounterCount] = {}, phases[PhaseCount] = {};
+    uint64_t histograms[HistogramCount][65] = {};
+
+    static uint64_t elapsed(Clock::time_point from, Clock::time_point to)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count();
+    }
+};
+
+using QueryStats = BasicQueryStats<engineStats>;
@@ -0,0 +1,175 @@
+#pragma once
+// Binary execution trace for the LBA simulators. Instead of printing the tape
+// on every step, a simulator records one fixed-size event per step into a
+// ring buffer: recording is a single store, so tracing can stay on in
+// production and the last `capacity` events are there for a post-mortem.
+//
+// Levels: off, sampled (only steps that are multiples of k) or full. A copy
+// of the tape is taken each time the ring wraps, so the offline decoder
+// (tracedump.cpp) can rebuild the tape before any retained step of a full
+// trace: writes after the checkpoint are replayed, writes before it are
+// undone using each event's `read` symbol.
+//
+// File layout (host byte order): "LBATRACE", version, level, sample period,
+// events recorded, capacity, event index of the checkpoint, state names,
+// checkpoint tape, then the retained events oldest first.
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "lba.h"
+
+enum class TraceLevel : uint32_t { Off = 0, Sampled = 1, Full = 2 };
+
+// One step, one sweep of `run` steps that moves without writing, or (run 0,
+// move NoMove) the configuration the machine halted in for lack of a move
+struct TraceEvent
+{
+    uint64_t step;  // Number of the (first) step
+    uint32_t state; // State before the step
+    int32_t head;   // Head before the step
+    uint32_t run;   // Steps covered
+    uint8_t read, write, move; // move as in LBAMove
+    uint8_t pad = 0;
+};
+static_assert(sizeof(TraceEvent) == 24, "trace events are written to disk as is");
+
+class TraceRing
+{
+  public:
+    static constexpr uint32_t version = 1;
+
+    // capacity is rounded up to a power of two
+    TraceRing(TraceLevel level = TraceLevel::Off, uint64_t every = 1, size_t capacity = 1 << 16)
+        : level(level), every(every ? every : 1)
+    {
+        size_t cap = 1;
+        while (cap < capacity)
+            cap *= 2;
+        events.resize(cap);
+        mask = cap - 1;
+    }
+
+    bool enabled() const { return level != TraceLevel::Off; }
+
+    // Start a run on `tape`, which must outlive it
+    void begin(const std::string *tape)
+    {
+        live = tape;
+        recorded = 0;
+    }
+
+    // Record a step (or sweep) before it changes the tape
+    void record(uint64_t step, uint32_t state, int head, unsigned char read, unsigned char write, LBAMove move,
+                uint32_t run = 1)
+    {
+        if (level == TraceLevel::Off)
+            return;
+        if (level == TraceLevel::Sampled && (step + run - 1) / every == (step - 1) / every)
+            return; // No multiple of k in [step, step + run)
+        if ((recorded & mask) == 0)
+        {
+            // About to overwrite the oldest event: checkpoint the tape
+            checkpoint = *live;
+            checkpointAt = recorded;
+        }
+        events[recorded++ & mask] = {step, state, head, run, read, write, (uint8_t)move};
+    }
+
+    // Write the retained events to `path`; false if the file can't be written
+    bool save(const std::string &path, const std::vector<std::string> &names) const
+    {
+        FILE *f = std::fopen(path.c_str(), "wb");
+        if (!f)
+            return false;
+        uint64_t capacity = events.size();
+        uint64_t first = recorded > capacity ? recorded - capacity : 0;
+        uint32_t lvl = (uint32_t)level, count = names.size(), tapeSize = checkpoint.size();
+        std::fwrite("LBATRACE", 1, 8, f);
+        std::fwrite(&version, 4, 1, f);
+        std::fwrite(&lvl, 4, 1, f);
+        std::fwrite(&every, 8, 1, f);
+        std::fwrite(&recorded, 8, 1, f);
+        std::fwrite(&capacity, 8, 1, f);
+        std::fwrite(&checkpointAt, 8, 1, f);
+        std::fwrite(&count, 4, 1, f);
+        for (auto &name : names)
+        {
+            uint32_t len = name.size();
+            std::fwrite(&len, 4, 1, f);
+            std::fwrite(name.data(), 1, len, f);
+        }
+        std::fwrite(&tapeSize, 4, 1, f);
+        std::fwrite(checkpoint.data(), 1, tapeSize, f);
+        for (uint64_t i = first; i < recorded; i++)
+            std::fwrite(&events[i & mask], sizeof(TraceEvent), 1, f);
+        return std::fclose(f) == 0;
+    }
+
+  private:
+    TraceLevel level;
+    uint64_t every;
+    std::vector<TraceEvent> events;
+    uint64_t mask = 0;
+    uint64_t recorded = 0;     // Events recorded so far; event i is in slot i & mask
+    const std::string *live = nullptr;
+    std::string checkpoint;    // Tape before event checkpointAt
+    uint64_t checkpointAt = 0;
+};
+
+// A saved trace, as read back by the decoder
+struct TraceFile
+{
+    TraceLevel level = TraceLevel::Off;
+    uint64_t every = 1, recorded = 0, capacity = 0, checkpointAt = 0;
+    std::vector<std::string> names;
+    std::string checkpoint;
+    std::vector<TraceEvent> events; // Oldest first; events[k] is event firstIndex() + k
+    uint64_t firstIndex() const { return recorded - events.size(); }
+
+    bool load(const std::string &path)
+    {
+        FILE *f = std::fopen(path.c_str(), "rb");
+        if (!f)
+            return false;
+        char magic[8];
+        uint32_t ver = 0, lvl = 0, count = 0, tapeSize = 0;
+        bool ok = std::fread(magic, 1, 8, f) == 8 && std::string(magic, 8) == "LBATRACE" &&
+                  std::fread(&ver, 4, 1, f) == 1 && ver == TraceRing::version && std::fread(&lvl, 4, 1, f) == 1 &&
+                  std::fread(&every, 8, 1, f) == 1 && std::fread(&recorded, 8, 1, f) == 1 &&
+                  std::fread(&capacity, 8, 1, f) == 1 && std::fread(&checkpointAt, 8, 1, f) == 1 &&
+                  std::fread(&count, 4, 1, f) == 1;
+        level = (TraceLevel)lvl;
+        ok = ok && recorded - checkpointAt <= capacity;
+        for (uint32_t s = 0; ok && s < count; s++)
+        {
+            uint32_t len = 0;
+            ok = std::fread(&len, 4, 1, f) == 1;
+            std::string name(len, '\0');
+            ok = ok && std::fread(&name[0], 1, len, f) == len;
+            names.push_back(name);
+        }
+        ok = ok && std::fread(&tapeSize, 4, 1, f) == 1;
+        checkpoint.assign(tapeSize, '\0');
+        ok = ok && std::fread(&checkpoint[0], 1, tapeSize, f) == tapeSize;
+        if (ok)
+            events.resize(std::min(recorded, capacity));
+        ok = ok && std::fread(events.data(), sizeof(TraceEvent), events.size(), f) == events.size();
+        std::fclose(f);
+        return ok;
+    }
+
+    // Tape just before retained event k, rebuilt from the checkpoint. Only
+    // exact for full traces, where no write is missing.
+    std::string tapeBefore(size_t k) const
+    {
+        std::string tape = checkpoint;
+        size_t at = checkpointAt - firstIndex(); // Checkpoint sits before event `at`
+        for (size_t i = at; i < k; i++)
+            tape[events[i].head] = events[i].write;
+        for (size_t i = at; i-- > k;)
+            tape[events[i].head] = events[i].read;
+        return tape;
+    }
+};
@@ -0,0 +1,85 @@
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+#include "trace.h"
+using namespace std;
+
+// Offline decoder for binary LBA traces (see trace.h, lba.cpp --trace-file)
+//   tracedump FILE              print every retained event
+//   tracedump FILE --last N     print the last N events
+//   tracedump FILE --tape STEP  rebuild the configuration before step STEP
+
+const char *moveName(uint8_t move)
+{
+    return move == MoveRight ? "R" : move == MoveLeft ? "L" : move == Stay ? "S" : "halt";
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        cerr << "Usage: tracedump FILE [--last N | --tape STEP]\n";
+        return 1;
+    }
+    TraceFile trace;
+    if (!trace.load(argv[1]))
+    {
+        cerr << "Cannot read trace " << argv[1] << "\n";
+        return 1;
+    }
+
+    const char *levels[] = {"off", "sampled", "full"};
+    cout << "Trace: " << levels[(int)trace.level];
+    if (trace.level == TraceLevel::Sampled)
+        cout << " (every " << trace.every << " steps)";
+    cout << ", " << trace.recorded << " events recorded, " << trace.events.size() << " retained\n";
+    if (trace.events.empty())
+        return 0;
+
+    // --tape STEP: the tape is exact only when no write was left out
+    if (argc > 3 && string(argv[2]) == "--tape")
+    {
+        uint64_t step = strtoull(argv[3], nullptr, 10);
+        if (trace.level != TraceLevel::Full)
+        {
+            cerr << "Tape snapshots need a full trace\n";
+            return 1;
+        }
+        // First retained event covering or following the step
+        size_t k = 0;
+        while (k < trace.events.size() && trace.events[k].step + max(trace.events[k].run, 1u) <= step)
+            k++;
+        const TraceEvent &first = trace.events.front();
+        if (step < first.step || k == trace.events.size())
+        {
+            cerr << "Step " << step << " is outside the retained steps " << first.step << ".."
+                 << trace.events.back().step + max(trace.events.back().run, 1u) - 1 << "\n";
+            return 1;
+        }
+        // Inside a sweep the head has moved but nothing was written
+        const TraceEvent &e = trace.events[k];
+        int64_t offset = step > e.step ? step - e.step : 0;
+        int64_t head = e.head + (e.move == MoveRight ? offset : e.move == MoveLeft ? -offset : 0);
+        cout << "Before step " << step << ": State=" << trace.names[e.state] << ", Head=" << head
+             << ", Tape=" << trace.tapeBefore(k) << "\n";
+        return 0;
+    }
+
+    size_t from = 0;
+    if (argc > 3 && string(argv[2]) == "--last")
+    {
+        size_t last = strtoull(argv[3], nullptr, 10);
+        from = last < trace.events.size() ? trace.events.size() - last : 0;
+    }
+    for (size_t k = from; k < trace.events.size(); k++)
+    {
+        const TraceEvent &e = trace.events[k];
+        cout << "Step " << e.step << ": State=" << trace.names[e.state] << ", Head=" << e.head << ", Read='"
+             << (char)e.read << "', Write='" << (char)e.write << "', Move=" << moveName(e.move);
+        if (e.run > 1)
+            cout << " x" << e.run;
+        cout << "\n";
+    }
+    return 0;
+}